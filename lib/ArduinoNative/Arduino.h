@@ -0,0 +1,134 @@
+/*
+  Arduino.h - Arduino API stand-in for the native (host) build
+
+  Only what the CW trainer and its libraries use is provided. Time comes
+  from a virtual clock: delay() and delayMicroseconds() advance it at
+  once, and every millis(), micros(), digitalRead(), analogRead(),
+  interrupts() and Serial.available() call costs nativeCallCost
+  microseconds, so busy-wait loops terminate. I2C transfers take their
+  time on the bus, see Wire.h.
+  Pin levels are supplied by a reader hook, pin writes are reported to
+  a writer hook, see the native* functions at the end of this file.
+  One timer interrupt and pin change interrupts on written pins are
+  emulated on the virtual clock, for code that checks ARDUINO_NATIVE.
+*/
+
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "avr/pgmspace.h"
+
+#define ARDUINO_NATIVE 1
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define A0 14
+#define A1 15
+#define A2 16
+#define A3 17
+#define A4 18
+#define A5 19
+#define SDA 18
+#define SCL 19
+#define NUM_DIGITAL_PINS 20
+
+#define _BV(bit) (1 << (bit))
+
+#define PI 3.1415926535897932384626433832795
+
+#define min(a,b) ((a)<(b)?(a):(b))
+#define max(a,b) ((a)>(b)?(a):(b))
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+
+typedef bool boolean;
+typedef uint8_t byte;
+typedef unsigned int word;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int val);
+
+void noInterrupts(void);
+void interrupts(void);
+
+char *dtostrf(double val, signed char width, unsigned char prec, char *s);
+
+void setup(void);
+void loop(void);
+
+#ifdef __cplusplus
+}
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+#include "Print.h"
+
+class HardwareSerial : public Print
+{
+  public:
+    void begin(unsigned long baud);
+    int available(void);
+    int read(void);
+    size_t write(uint8_t c);
+    void inject(const char *s);   // queue characters as if they were typed
+    void inject(const char *s, unsigned long ms);  // type s (kept, not copied) from virtual time ms on, one character per ms
+    operator bool() { return true; }
+};
+
+extern HardwareSerial Serial;
+
+// Virtual clock and pin hooks of the native build
+typedef int (*nativePinReader)(uint8_t pin, unsigned long us);
+typedef void (*nativePinWriter)(uint8_t pin, int val, unsigned long us);
+typedef void (*nativeSerialWriter)(uint8_t c);
+
+extern unsigned long nativeCallCost;    // us per clock or pin read, default 1
+extern unsigned long long nativeLimit;  // exit when the clock passes this (us), 0: never
+
+void nativeAdvance(unsigned long us);
+unsigned long long nativeTime(void);    // virtual time in us, not wrapped
+void nativeSetPinReader(nativePinReader reader);
+void nativeSetPinWriter(nativePinWriter writer);
+void nativeSetExitHook(void (*hook)(void));
+void nativeSetSerialWriter(nativeSerialWriter writer);  // Serial output, NULL: stdout
+
+// Timer interrupt: isr runs every period us of virtual time, like a timer
+// in CTC mode, until a period of 0. A period set from the isr itself
+// applies from the next compare match on.
+void nativeTimer(unsigned long period, void (*isr)(void));
+
+// Pin change interrupt: isr runs when a write changes the level of pin.
+// False for inputs fed by the reader hook, those have no edges to see.
+bool nativePinChange(uint8_t pin, void (*isr)(void));
+int nativePinLevel(uint8_t pin);        // without the cost of digitalRead()
+
+#endif
+
+#endif
@@ -0,0 +1,327 @@
+/*
+  ArduinoNative.cpp - virtual clock, pins, Serial and main() of the native build
+
+  Usage: program [seconds]
+  Runs setup() and loop() until the virtual clock has passed the given
+  number of seconds (forever without an argument). Characters on stdin
+  are delivered through Serial, so the menus can be driven with e.g.
+    echo " " | .pio/build/native/program 3600
+*/
+
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "Arduino.h"
+#include "EEPROM.h"
+#include "SPI.h"
+
+unsigned long nativeCallCost = 1;
+unsigned long long nativeLimit = 0;
+
+static unsigned long long now_us;
+static nativePinReader pin_reader;
+static nativePinWriter pin_writer;
+static void (*exit_hook)(void);
+static uint8_t pin_level[NUM_DIGITAL_PINS];
+static uint8_t pin_mode[NUM_DIGITAL_PINS];
+static void (*pin_change[NUM_DIGITAL_PINS])(void);
+static void (*timer_isr)(void);
+static unsigned long timer_period;
+static unsigned long long timer_base;   // time of the last compare match
+static bool in_isr;
+
+HardwareSerial Serial;
+EEPROMClass EEPROM;
+SPIClass SPI;
+
+
+
+//==================
+// Virtual clock
+//==================
+
+void nativeAdvance(unsigned long us)
+{
+  unsigned long long to = now_us + us;
+
+  // Run the timer interrupt at its own times on the way
+  while (timer_isr && !in_isr && timer_base + timer_period <= to) {
+    now_us = timer_base = timer_base + timer_period;
+    in_isr = true;
+    timer_isr();
+    in_isr = false;
+  }
+  if (to > now_us)
+    now_us = to;
+
+  if (nativeLimit != 0 && now_us >= nativeLimit) {
+    if (exit_hook)
+      exit_hook();
+    fflush(stdout);
+    exit(0);
+  }
+}
+
+unsigned long long nativeTime(void)
+{
+  return now_us;
+}
+
+void nativeTimer(unsigned long period, void (*isr)(void))
+{
+  // From the interrupt itself the new period follows the current one
+  if (!in_isr)
+    timer_base = now_us;
+  timer_period = period;
+  timer_isr = period ? isr : NULL;
+}
+
+void nativeSetExitHook(void (*hook)(void))
+{
+  exit_hook = hook;
+}
+
+unsigned long millis(void)
+{
+  nativeAdvance(nativeCallCost);
+  return (unsigned long)(now_us / 1000);
+}
+
+unsigned long micros(void)
+{
+  nativeAdvance(nativeCallCost);
+  return (unsigned long)now_us;
+}
+
+void delay(unsigned long ms)
+{
+  nativeAdvance(ms * 1000UL);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  nativeAdvance(us);
+}
+
+
+
+//==================
+// Pins
+//==================
+
+void nativeSetPinReader(nativePinReader reader)
+{
+  pin_reader = reader;
+}
+
+void nativeSetPinWriter(nativePinWriter writer)
+{
+  pin_writer = writer;
+}
+
+bool nativePinChange(uint8_t pin, void (*isr)(void))
+{
+  if (pin >= NUM_DIGITAL_PINS)
+    return false;
+  // Levels from the reader hook only show up when they are read
+  if (isr && pin_reader && pin_mode[pin] != OUTPUT)
+    return false;
+  pin_change[pin] = isr;
+  return true;
+}
+
+int nativePinLevel(uint8_t pin)
+{
+  return pin < NUM_DIGITAL_PINS ? pin_level[pin] : LOW;
+}
+
+static void set_level(uint8_t pin, uint8_t level)
+{
+  bool was = in_isr;
+  if (pin_level[pin] == level)
+    return;
+  pin_level[pin] = level;
+  if (pin_change[pin]) {
+    in_isr = true;
+    pin_change[pin]();
+    in_isr = was;
+  }
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+  if (pin >= NUM_DIGITAL_PINS)
+    return;
+  pin_mode[pin] = mode;
+  if (mode == INPUT_PULLUP)
+    pin_level[pin] = HIGH;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+  if (pin >= NUM_DIGITAL_PINS)
+    return;
+  set_level(pin, val ? HIGH : LOW);
+  if (pin_writer)
+    pin_writer(pin, pin_level[pin], (unsigned long)now_us);
+}
+
+int digitalRead(uint8_t pin)
+{
+  nativeAdvance(nativeCallCost);
+  if (pin_reader)
+    return pin_reader(pin, (unsigned long)now_us);
+  return pin < NUM_DIGITAL_PINS ? pin_level[pin] : LOW;
+}
+
+int analogRead(uint8_t pin)
+{
+  nativeAdvance(nativeCallCost);
+  if (pin_reader)
+    return pin_reader(pin, (unsigned long)now_us);
+  return 0;
+}
+
+void analogWrite(uint8_t pin, int val)
+{
+  if (pin < NUM_DIGITAL_PINS)
+    set_level(pin, val ? HIGH : LOW);
+  if (pin_writer)
+    pin_writer(pin, val, (unsigned long)now_us);
+}
+
+void noInterrupts(void)
+{
+}
+
+// Polling a flag shared with an interrupt takes time too, so the end of
+// a noInterrupts() section is charged like a pin read
+void interrupts(void)
+{
+  if (!in_isr)
+    nativeAdvance(nativeCallCost);
+}
+
+
+
+//==================
+// Serial on stdio
+//==================
+
+static char serial_rx[256];
+static unsigned int serial_head, serial_tail;
+static nativeSerialWriter serial_writer;
+
+// Typed input scripted by inject(s, ms), like stdin one character per ms
+#define NATIVE_SERIAL_SCRIPTS 8
+static struct {
+  const char *s;
+  unsigned long long at;
+} serial_script[NATIVE_SERIAL_SCRIPTS];
+
+void nativeSetSerialWriter(nativeSerialWriter writer)
+{
+  serial_writer = writer;
+}
+
+void HardwareSerial::begin(unsigned long baud)
+{
+  (void)baud;
+  fcntl(0, F_SETFL, fcntl(0, F_GETFL) | O_NONBLOCK);
+}
+
+void HardwareSerial::inject(const char *s)
+{
+  while (*s && serial_head - serial_tail < sizeof(serial_rx))
+    serial_rx[serial_head++ % sizeof(serial_rx)] = *s++;
+}
+
+void HardwareSerial::inject(const char *s, unsigned long ms)
+{
+  for (int i = 0; i < NATIVE_SERIAL_SCRIPTS; i++)
+    if (!serial_script[i].s) {
+      serial_script[i].s = s;
+      serial_script[i].at = ms * 1000ULL;
+      return;
+    }
+}
+
+int HardwareSerial::available(void)
+{
+  static unsigned long long last_poll;
+  char c;
+  nativeAdvance(nativeCallCost);
+  for (int i = 0; i < NATIVE_SERIAL_SCRIPTS && serial_head == serial_tail; i++) {
+    if (!serial_script[i].s || now_us < serial_script[i].at)
+      continue;
+    serial_rx[serial_head++ % sizeof(serial_rx)] = *serial_script[i].s++;
+    serial_script[i].at = now_us + 1000;
+    if (!*serial_script[i].s)
+      serial_script[i].s = NULL;
+  }
+  // look at stdin once per virtual millisecond, like a 9600 baud UART
+  if (serial_head == serial_tail && now_us - last_poll >= 1000) {
+    last_poll = now_us;
+    if (::read(0, &c, 1) == 1)
+      serial_rx[serial_head++ % sizeof(serial_rx)] = c;
+  }
+  return serial_head - serial_tail;
+}
+
+int HardwareSerial::read(void)
+{
+  if (!available())
+    return -1;
+  return (unsigned char)serial_rx[serial_tail++ % sizeof(serial_rx)];
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+  if (serial_writer)
+    serial_writer(c);
+  else
+    putchar(c);
+  return 1;
+}
+
+
+
+//==================
+// Misc
+//==================
+
+long random(long howbig)
+{
+  if (howbig == 0)
+    return 0;
+  return ::random() % howbig;
+}
+
+long random(long howsmall, long howbig)
+{
+  if (howsmall >= howbig)
+    return howsmall;
+  return random(howbig - howsmall) + howsmall;
+}
+
+void randomSeed(unsigned long seed)
+{
+  if (seed != 0)
+    srandom(seed);
+}
+
+char *dtostrf(double val, signed char width, unsigned char prec, char *s)
+{
+  sprintf(s, "%*.*f", width, prec, val);
+  return s;
+}
+
+// weak, so a test or benchmark program can drive setup() and loop() itself
+__attribute__((weak)) int main(int argc, char **argv)
+{
+  if (argc > 1)
+    nativeLimit = strtoull(argv[1], NULL, 10) * 1000000ULL;
+  setup();
+  for (;;)
+    loop();
+}
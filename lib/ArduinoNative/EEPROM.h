@@ -0,0 +1,25 @@
+/*
+  EEPROM.h - EEPROM stand-in for the native build, kept in RAM.
+  Erased cells read 0xFF like on the ATmega328.
+*/
+
+#ifndef EEPROM_h
+#define EEPROM_h
+
+#include <inttypes.h>
+#include <string.h>
+
+#define NATIVE_EEPROM_SIZE 1024
+
+class EEPROMClass
+{
+  public:
+    EEPROMClass() { memset(cells, 0xFF, sizeof(cells)); }
+    uint8_t read(int address) { return cells[address % NATIVE_EEPROM_SIZE]; }
+    void write(int address, uint8_t value) { cells[address % NATIVE_EEPROM_SIZE] = value; }
+    uint8_t cells[NATIVE_EEPROM_SIZE];
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
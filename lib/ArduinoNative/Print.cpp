@@ -0,0 +1,43 @@
+/*
+  Print.cpp - Print base class stand-in for the native build
+*/
+
+#include <stdio.h>
+#include "Print.h"
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+  size_t n = 0;
+  while (size--)
+    n += write(*buffer++);
+  return n;
+}
+
+size_t Print::print(long n, int base)
+{
+  if (base == DEC && n < 0)
+    return print('-') + print((unsigned long)-n, base);
+  return print((unsigned long)n, base);
+}
+
+size_t Print::print(unsigned long n, int base)
+{
+  char buf[8 * sizeof(long) + 1];
+  char *p = &buf[sizeof(buf) - 1];
+  if (base < 2)
+    base = 10;
+  *p = '\0';
+  do {
+    char c = n % base;
+    n /= base;
+    *--p = c < 10 ? c + '0' : c + 'A' - 10;
+  } while (n);
+  return write(p);
+}
+
+size_t Print::print(double n, int digits)
+{
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.*f", digits, n);
+  return write(buf);
+}
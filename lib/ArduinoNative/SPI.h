@@ -0,0 +1,43 @@
+/*
+  SPI.h - SPI stand-in for the native build, transfers go nowhere.
+*/
+
+#ifndef _SPI_H_INCLUDED
+#define _SPI_H_INCLUDED
+
+#include "Arduino.h"
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x04
+#define SPI_MODE2 0x08
+#define SPI_MODE3 0x0C
+
+#define SPI_CLOCK_DIV2 0x04
+#define SPI_CLOCK_DIV4 0x00
+#define SPI_CLOCK_DIV8 0x05
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+class SPISettings
+{
+  public:
+    SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode) { (void)clock; (void)bitOrder; (void)dataMode; }
+};
+
+class SPIClass
+{
+  public:
+    void begin() {}
+    void end() {}
+    void beginTransaction(SPISettings) {}
+    void endTransaction() {}
+    uint8_t transfer(uint8_t) { return 0; }
+    void setBitOrder(uint8_t) {}
+    void setDataMode(uint8_t) {}
+    void setClockDivider(uint8_t) {}
+};
+
+extern SPIClass SPI;
+
+#endif
@@ -0,0 +1,95 @@
+/*
+  Wire.cpp - I2C stand-in for the native build, see Wire.h
+*/
+
+#include <stdio.h>
+#include "Wire.h"
+
+TwoWire Wire;
+
+void TwoWire::beginTransmission(uint8_t adr)
+{
+  address = adr;
+  first = 1;
+  bytes++;
+  busTime();
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+    write(data[i]);
+  return n;
+}
+
+size_t TwoWire::write(uint8_t b)
+{
+  bytes++;
+  busTime();
+  if (address != NATIVE_SSD1306_ADR)
+    return 1;
+  if (first) {
+    first = 0;
+    is_data = (b & 0x40) != 0;
+    return 1;
+  }
+  if (!is_data) {
+    command(b);
+    return 1;
+  }
+  ram[page % NATIVE_SSD1306_PAGES][col % NATIVE_SSD1306_COLS] = b;
+  col++;
+  return 1;
+}
+
+uint8_t TwoWire::endTransmission(void)
+{
+  transfers++;
+  return 0;
+}
+
+// 8 data bits and the acknowledge per byte
+void TwoWire::busTime(void)
+{
+  ns += 9000000000ULL / clock;
+  if (ns >= 1000) {
+    nativeAdvance(ns / 1000);
+    ns %= 1000;
+  }
+}
+
+// commands with arguments are sent in separate transfers by u8x8, so the
+// argument count survives the end of a transfer
+void TwoWire::command(uint8_t c)
+{
+  if (args) {
+    args--;
+    return;
+  }
+  if (c < 0x10)
+    col = (col & 0xF0) | c;
+  else if (c < 0x20)
+    col = (col & 0x0F) | ((c & 0x0F) << 4);
+  else if (c >= 0x40 && c <= 0x7F)
+    start = c & 0x3F;
+  else if (c >= 0xB0 && c <= 0xB7)
+    page = c & 7;
+  else if (c == 0x26 || c == 0x27)
+    args = 6;
+  else if (c == 0x29 || c == 0x2A)
+    args = 5;
+  else if (c == 0x21 || c == 0x22 || c == 0xA3)
+    args = 2;
+  else if (c == 0x20 || c == 0x81 || c == 0x8D || c == 0xA8 || c == 0xD3 ||
+           c == 0xD5 || c == 0xD9 || c == 0xDA || c == 0xDB)
+    args = 1;
+}
+
+void TwoWire::dump(void)
+{
+  for (int y = 0; y < 32; y++) {
+    for (int x = 0; x < NATIVE_SSD1306_COLS; x++)
+      putchar((ram[((y + start) & 63) >> 3][x] >> ((y + start) & 7)) & 1 ? '#' : '.');
+    putchar('\n');
+  }
+}
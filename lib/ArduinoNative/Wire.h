@@ -0,0 +1,51 @@
+/*
+  Wire.h - I2C stand-in for the native build
+
+  Transfers to the SSD1306 address (0x3C) are decoded into a copy of the
+  display RAM (page addressing mode, as used by u8x8), so a test can look
+  at what is on the screen. Byte and transfer counts are kept as well.
+  Every byte advances the virtual clock by its 9 bit times at the clock
+  set, like the real bus would.
+*/
+
+#ifndef TwoWire_h
+#define TwoWire_h
+
+#include "Arduino.h"
+
+#define NATIVE_SSD1306_ADR 0x3C
+#define NATIVE_SSD1306_COLS 128
+#define NATIVE_SSD1306_PAGES 8
+
+class TwoWire
+{
+  public:
+    void begin() {}
+    void setClock(uint32_t hz) { clock = hz; }
+    void beginTransmission(uint8_t address);
+    size_t write(uint8_t data);
+    size_t write(const uint8_t *data, size_t n);
+    uint8_t endTransmission(void);
+
+    uint8_t ram[NATIVE_SSD1306_PAGES][NATIVE_SSD1306_COLS];  // display RAM, lsb on top
+    uint8_t start;             // display start line, the first line shown
+    unsigned long transfers;   // completed transfers to the display
+    unsigned long bytes;       // bytes on the wire incl. address byte
+
+    void dump(void);           // print the 32 lines shown to stdout
+
+  private:
+    void command(uint8_t c);
+    void busTime(void);
+    uint32_t clock = 100000;   // Hz, the Arduino default
+    uint32_t ns;               // bus time not on the clock yet
+    uint8_t address;
+    uint8_t first;             // next byte is the control byte
+    uint8_t is_data;
+    uint8_t args;              // argument bytes still expected by the last command
+    uint8_t page, col;
+};
+
+extern TwoWire Wire;
+
+#endif
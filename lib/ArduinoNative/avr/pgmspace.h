@@ -0,0 +1,29 @@
+/*
+  avr/pgmspace.h - flash access stand-in for the native build,
+  program memory is ordinary memory on the host.
+*/
+
+#ifndef native_pgmspace_h
+#define native_pgmspace_h
+
+#include <string.h>
+
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(s) (s)
+#define F(s) (s)
+
+#define pgm_read_byte(addr) (*(const unsigned char *)(addr))
+/* word reads return the element itself, tables of string pointers */
+/* read with pgm_read_word() keep their full host pointer width */
+#define pgm_read_word(addr) (*(addr))
+#define pgm_read_dword(addr) (*(addr))
+#define pgm_read_ptr(addr) (*(addr))
+
+#define strcpy_P strcpy
+#define strncpy_P strncpy
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define memcpy_P memcpy
+
+#endif
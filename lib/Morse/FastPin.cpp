@@ -0,0 +1,35 @@
+//
+// Fast pin access for the Morse library
+//
+// Released under GPLv3
+//
+
+#include "Arduino.h"
+#include "FastPin.h"
+
+#if defined(__AVR__) && !defined(MORSE_NO_FAST_PIN)
+
+volatile uint8_t MorsePin::_none;
+
+void MorsePin::attach(uint8_t pin)
+{
+  uint8_t port = pin < NUM_DIGITAL_PINS ? digitalPinToPort(pin) : NOT_A_PIN;
+  if (port == NOT_A_PIN) {
+    _out = &_none;
+    _in = &_none;
+    _mask = 0;
+    return;
+  }
+  _out = portOutputRegister(port);
+  _in = portInputRegister(port);
+  _mask = digitalPinToBitMask(pin);
+}
+
+#else
+
+void MorsePin::attach(uint8_t pin)
+{
+  _pin = pin < NUM_DIGITAL_PINS ? pin : MORSE_NO_PIN;
+}
+
+#endif
@@ -0,0 +1,110 @@
+//
+// Fast pin access for the Morse library
+//
+// Released under GPLv3
+//
+// digitalWrite() and digitalRead() look the pin up in three flash tables
+// and check for a PWM timer on every call, some 50 to 60 cycles each.
+//
+// FastPin<pin> is for pins fixed at compile time. On the ATmega328 family
+// every call compiles to a single sbi, cbi or sbis instruction. Morse,
+// morseDecoder and morseEncoder take one in their fixed-pin overloads.
+//
+// MorsePin is for the pins passed to Morse and morseDecoder at run time.
+// It looks the port and bit up once in attach(). A read after that is a
+// load and a mask, and a write is a read-modify-write of the port with
+// interrupts held off, about 10 cycles.
+//
+// Elsewhere, in the native build where pin writes must reach its hooks,
+// and with MORSE_NO_FAST_PIN defined, both fall back to digitalWrite()
+// and digitalRead().
+//
+// Usage:
+//         FastPin<13>::output();
+//         FastPin<13>::high();	one sbi
+//
+//         MorsePin key;
+//         key.attach(pin);	after pinMode(), and after any analogWrite()
+//         key.write(true);
+//
+
+#ifndef FastPin_h
+#define FastPin_h
+
+#include "Arduino.h"
+
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega328__) || defined(__AVR_ATmega168__) || defined(__AVR_ATmega168P__)
+#define FASTPIN_ATMEGA328
+#endif
+
+#define FASTPIN_INLINE static inline __attribute__((always_inline))
+
+#define MORSE_NO_PIN 0xFF
+
+#if defined(FASTPIN_ATMEGA328) && !defined(MORSE_NO_FAST_PIN)
+
+// Arduino pins 0..7 are port D, 8..13 port B and 14..19 (A0..A5) port C
+template <uint8_t PIN>
+class FastPin
+{
+	static_assert(PIN < 20, "FastPin: no such pin on the ATmega328");
+	public:
+		FASTPIN_INLINE void output() { _ddr() |= _mask(); }
+		FASTPIN_INLINE void input() { _ddr() &= ~_mask(); _port() &= ~_mask(); }
+		FASTPIN_INLINE void inputPullup() { _ddr() &= ~_mask(); _port() |= _mask(); }
+		FASTPIN_INLINE void high() { _port() |= _mask(); }
+		FASTPIN_INLINE void low() { _port() &= ~_mask(); }
+		FASTPIN_INLINE void write(boolean on) { if (on) high(); else low(); }
+		FASTPIN_INLINE void toggle() { _pin() = _mask(); }	// writing PINx flips the output
+		FASTPIN_INLINE boolean read() { return (_pin() & _mask()) != 0; }
+	private:
+		FASTPIN_INLINE volatile uint8_t &_port() { return PIN < 8 ? PORTD : PIN < 14 ? PORTB : PORTC; }
+		FASTPIN_INLINE volatile uint8_t &_ddr() { return PIN < 8 ? DDRD : PIN < 14 ? DDRB : DDRC; }
+		FASTPIN_INLINE volatile uint8_t &_pin() { return PIN < 8 ? PIND : PIN < 14 ? PINB : PINC; }
+		FASTPIN_INLINE uint8_t _mask() { return 1 << (PIN < 8 ? PIN : PIN < 14 ? PIN - 8 : PIN - 14); }
+};
+
+#else
+
+template <uint8_t PIN>
+class FastPin
+{
+	public:
+		FASTPIN_INLINE void output() { pinMode(PIN, OUTPUT); }
+		FASTPIN_INLINE void input() { pinMode(PIN, INPUT); }
+		FASTPIN_INLINE void inputPullup() { pinMode(PIN, INPUT_PULLUP); }
+		FASTPIN_INLINE void high() { digitalWrite(PIN, HIGH); }
+		FASTPIN_INLINE void low() { digitalWrite(PIN, LOW); }
+		FASTPIN_INLINE void write(boolean on) { digitalWrite(PIN, on ? HIGH : LOW); }
+		FASTPIN_INLINE void toggle() { digitalWrite(PIN, !digitalRead(PIN)); }
+		FASTPIN_INLINE boolean read() { return digitalRead(PIN) != LOW; }
+};
+
+#endif
+
+class MorsePin
+{
+	public:
+		MorsePin() { attach(MORSE_NO_PIN); }
+		void attach(uint8_t pin);	// MORSE_NO_PIN or out of range: writes do nothing, reads are LOW
+#if defined(__AVR__) && !defined(MORSE_NO_FAST_PIN)
+		void write(boolean on) {
+			uint8_t oldSREG = SREG;
+			cli();
+			if (on) *_out |= _mask; else *_out &= ~_mask;
+			SREG = oldSREG;
+		}
+		boolean read() { return (*_in & _mask) != 0; }
+	private:
+		volatile uint8_t *_out;
+		volatile uint8_t *_in;
+		uint8_t _mask;		// 0 if not a pin, the registers then point to a dummy
+		static volatile uint8_t _none;
+#else
+		void write(boolean on) { if (_pin != MORSE_NO_PIN) digitalWrite(_pin, on ? HIGH : LOW); }
+		boolean read() { return _pin != MORSE_NO_PIN && digitalRead(_pin) != LOW; }
+	private:
+		uint8_t _pin;
+#endif
+};
+#endif
@@ -13,214 +13,272 @@
 //         Morse <handle>(<outputpin>, <speed>);
 //         <handle>.sendmsg (*str);
 //         <handle>.send (*char);
+//         <handle>.queue (*str);	non-blocking, timed from Timer1
+//         <handle>.done ();
+//         <handle>.pitch (<hz>);	sine sidetone (beep 2) only
+//         <handle>.addOutput (<pin>, <beep>);	key a second output in step
+//         <handle>.addOutput (FastPin<pin>());	a key output on a fixed pin
+//         <handle>.farnsworth (<wpm>);	Farnsworth spacing
+//         <handle>.trim (<permille>);	speed correction
 
 #include "Arduino.h"
 #include "Morse.h"
+#include "MorseCode.h"
+#include "Sidetone.h"
 
-  byte _speed;	// Speed in WPM
-  byte _pin;	// Pin to beep or toggle
-  byte _beep;	// 1 == beep to speaker, 0 == toggle pin high and low
-  int _dashlen;	// Length of dash
-  int _dotlen;	// Length of dot
-const  byte _morsetab[] = {	// Those with value 1 has no morsecode - code is decimal - but converted to reverse binary to send
-    117, //ASCII 33 !   
-    82,  //ASCII 34 "   
-    1,   //ASCII 35 #   
-    200, //ASCII 36 $   
-    1,   //ASCII 37 %   
-    34,  //ASCII 38 &   
-    94,  //ASCII 39 '  
-    45, //ASCII 40 (	
-    109, //ASCII 41 )   
-    1,   //ASCII 42 *   
-    42,  //ASCII 43 +   
-    115, //ASCII 44 ,   
-    97,  //ASCII 45 -   
-    106,  //ASCII 46 .  
-    41,  //ASCII 47 /  
-    63,  //ASCII 48 0
-    62,  //ASCII 49 1
-    60,  //ASCII 50 2
-    56,  //ASCII 51 3
-    48,  //ASCII 52 4
-    32,  //ASCII 53 5
-    33,  //ASCII 54 6
-    35,  //ASCII 55 7
-    39,  //ASCII 56 8
-    47,  //ASCII 57 9
-    71, //ASCII 58 :	
-    85,  //ASCII 59 ;	
-    1,   //ASCII 60 <
-    49,  //ASCII 61 =
-    1,   //ASCII 62 >
-    76,  //ASCII 63 ?
-    86,  //ASCII 64 @	
-    6,   //ASCII 65 A
-    17,  //ASCII 66 B
-    21,  //ASCII 67 C
-    9,   //ASCII 68 D
-    2,   //ASCII 69 E
-    20,  //ASCII 70 F
-    11,  //ASCII 71 G
-    16,  //ASCII 72 H
-    4,   //ASCII 73 I
-    30,  //ASCII 74 J
-    13,  //ASCII 75 K
-    18,  //ASCII 76 L
-    7,   //ASCII 77 M
-    5,   //ASCII 78 N
-    15,  //ASCII 79 O
-    22,  //ASCII 80 P
-    27,  //ASCII 81 Q
-    10,  //ASCII 82 R
-    8,   //ASCII 83 S
-    3,   //ASCII 84 T
-    12,  //ASCII 85 U
-    24,  //ASCII 86 V
-    14,  //ASCII 87 W
-    25,  //ASCII 88 X
-    29,  //ASCII 89 Y
-    19,  //ASCII 90 Z
-    1,   //ASCII 91 [    
-    64,   //ASCII 92 backslash    
-    1,   //ASCII 93 ]   
-    1,   //ASCII 94 ^
-    108,  //ASCII 95 _    
-    94,  //ASCII 96 `    
-    6,   //ASCII 97 a
-    17,  //ASCII 98 b
-    21,  //ASCII 99 c
-    9,   //ASCII 100 d
-    2,   //ASCII 101 e
-    20,  //ASCII 102 f
-    11,  //ASCII 103 g
-    16,  //ASCII 104 h
-    4,   //ASCII 105 i
-    30,  //ASCII 106 j
-    13,  //ASCII 107 k
-    18,  //ASCII 108 l
-    7,   //ASCII 109 m
-    5,   //ASCII 110 n
-    15,  //ASCII 111 o
-    22,  //ASCII 112 p
-    27,  //ASCII 113 q
-    10,  //ASCII 114 r
-    8,   //ASCII 115 s
-    3,   //ASCII 116 t
-    12,  //ASCII 117 u
-    24,  //ASCII 118 v
-    14,  //ASCII 119 w
-    25,  //ASCII 120 x
-    29,  //ASCII 121 y
-    19,   //ASCII 122 z
-    1,   //ASCII 123 left brace
-    1,   //ASCII 124 vertical bar
-    1,   //ASCII 125 right brace
-    1,   //ASCII 126 tilde
-    };
-  
-Morse::Morse(byte pin, byte speed, byte beep)
+Morse * volatile Morse::_timed = 0;
+
+Morse::Morse(byte pin, byte speed, byte beep) : Morse(speed)
+{
+  addOutput(pin, beep);
+}
+
+Morse::Morse(byte speed)
 {
   // Save values for later use
-  _pin = pin;
   _speed = speed;
-  _beep = beep;
+  _outputs = 0;
+  _qhead = 0;
+  _qtail = 0;
+  _pc = 0;
+  _plen = 0;
+  _playing = false;
+  _keyed = false;
+  _active = false;
 
-  // Calculate the length of dash and dot
-  _dotlen = (1200/_speed);
-  _dashlen =  (3*_dotlen);
+  _timing.setSpeed(_speed, 0);
+}
+
+Morse::~Morse()
+{
+  // Don't leave Timer1 sending for an object that is gone
+  if (_timed == this) stop();
+
+  // nor Timer2 playing the sidetone it started
+  for (byte i = 0; i < _outputs; i++)
+    if (_beep[i] == 2) {
+      Sidetone::end();
+      break;
+    }
+}
+
+// Every output is switched from the same call, in the blocking sender and
+// in the Timer1 interrupt alike, so they all follow one timing.
+boolean Morse::addOutput(byte pin, byte beep)
+{
+  if (_outputs == MORSE_MAX_OUTPUTS) return false;
+  _pin[_outputs] = pin;
+  _beep[_outputs] = beep;
+  _fixed[_outputs] = 0;
+  _outputs++;
 
   // Set the pin to output mode
-  pinMode(_pin, OUTPUT);
+  if (beep == 2) {
+    Sidetone::begin(pin, 700);
+  } else {
+    pinMode(pin, OUTPUT);
+    if (beep == 0) {
+      digitalWrite(pin, LOW);	// also stops any PWM left on it
+      _port[_outputs - 1].attach(pin);
+    }
+  }
+  return true;
 }
 
-void Morse::dash()
+void Morse::pitch(unsigned int hz)
 {
-  digitalWrite(_pin, HIGH);
-  delay(_dashlen);
-  digitalWrite(_pin, LOW);
-  delay(_dotlen);
+  Sidetone::pitch(hz);
 }
 
-void Morse::dit()
+void Morse::farnsworth(byte wpm)
 {
-  digitalWrite(_pin, HIGH);
-  delay(_dotlen);
-  digitalWrite(_pin, LOW);
-  delay(_dotlen);
+  _timing.setSpeed(_speed, wpm);
 }
 
-void Morse::bdash()
+void Morse::trim(int permille)
 {
-  analogWrite(_pin, 128);
-  delay(_dashlen);
-  analogWrite(_pin, 0);
-  delay(_dotlen);
+  _timing.setTrim(permille);
 }
 
-void Morse::bdit()
+// Key all outputs on or off
+void Morse::_key(boolean on)
 {
-  analogWrite(_pin, 128);
-  delay(_dotlen);
-  analogWrite(_pin, 0);
-  delay(_dotlen);
+  for (byte i = 0; i < _outputs; i++) {
+    switch (_beep[i]) {
+      case 0:
+        if (_fixed[i]) _fixed[i](on);
+        else _port[i].write(on);
+        break;
+      case 1:
+        analogWrite(_pin[i], on ? 128 : 0);
+        break;
+      case 2:
+        Sidetone::key(on);
+        break;
+    }
+  }
+  _keyed = on;
 }
 
 void Morse::send(char c)
 {
+  uint16_t prog[MORSE_TIMING_CHAR];
+  byte n = _timing.compile(c, prog, MORSE_TIMING_CHAR);
 
-  byte _i;
-  byte _p;
+  // Wait for the end of each run on micros(), so the time spent keying
+  // doesn't add to it
+  unsigned long t = micros();
+  for (byte i = 0; i < n; i++) {
+    _key(prog[i] & MORSE_TIMING_MARK);
+    t += MorseTiming::duration(prog[i]);
+    while ((long)(micros() - t) < 0)
+      ;
+  }
+}
 
-  // Send space
-  if (c == ' ') {
-    delay(7*_dotlen) ;
-    return ;
+void Morse::sendmsg(char *str)
+{
+  while (*str) {
+    send(*str++);
   }
-  
-  // Do a table lookup to get morse data
-  else {
-    _i = ((byte) c) - 33;
-    _p = _morsetab[_i];
+}
 
 
+// Timer driven sender
+//
+// The interrupt compiles each character to a timing program as it fetches
+// it. Timer1 runs in CTC mode at clk/1024, and every compare match starts
+// the next run of the program with OCR1A set to its length, so the key
+// transitions don't depend on what the main loop is doing. There is one
+// Timer1, so one Morse object at a time sends from it.
+
+void Morse::_timerStart()
+{
+#ifdef __AVR__
+  TCCR1B = 0;
+  TCCR1A = 0;
+  TCNT1 = 0;
+  TIFR1 = _BV(OCF1A);
+  TIMSK1 |= _BV(OCIE1A);
+  TCCR1B = _BV(WGM12) | _BV(CS12) | _BV(CS10);	// CTC on OCR1A, clk/1024
+#endif
+  _timed = this;
+}
+
+void Morse::_timerStop()
+{
+  if (_timed == this) {
+#ifdef __AVR__
+    TIMSK1 &= ~_BV(OCIE1A);
+    TCCR1B = 0;
+#elif defined(ARDUINO_NATIVE)
+    nativeTimer(0, 0);
+#endif
+    _timed = 0;
   }
+  _playing = false;
+}
 
-  // Main algoritm for each morse sign
-  while (_p != 1) {
-    if (_p & 1)
-      switch (_beep) {
-	case 0:
-	  dash();
-	  break;
-        case 1:
-          bdash();
-          break;
-        default:
-          break;
-      }
-    else
-      switch (_beep) {
-	case 0:
-	  dit();
-	  break;
-        case 1:
-          bdit();
-          break;
-        default:
-          break;
+// Called when the current run has had its time
+void Morse::_next()
+{
+  if (_pc == _plen) {
+    // Character and its gap finished, fetch and compile the next one
+    _active = false;
+    do {
+      byte tail = _qtail;
+      if (tail == _qhead) {
+        _timerStop();
+        return;
       }
-    _p = _p / 2;
+      char c = _queue[tail];
+      _qtail = (tail + 1) & (MORSE_QUEUE_SIZE - 1);
+      _plen = _timing.compile(c, _prog, MORSE_TIMING_CHAR);
+    } while (!_plen);
+    _pc = 0;
+    _active = true;
   }
-  // Letterspace
-  delay(2*_dotlen);
+
+  uint16_t run = _prog[_pc++];
+  boolean mark = run & MORSE_TIMING_MARK;
+  if (mark != _keyed) _key(mark);
+#ifdef __AVR__
+  OCR1A = (run & MORSE_TIMING_MAX) - 1;
+#elif defined(ARDUINO_NATIVE)
+  nativeTimer(MorseTiming::duration(run), Morse::tick);
+#endif
+  _playing = true;
 }
 
-void Morse::sendmsg(char *str)
+void Morse::tick()
 {
-  while (*str) {
-    send(*str++);
+  Morse *m = _timed;
+  if (m && m->_playing) m->_next();
+}
+
+boolean Morse::queue(char c)
+{
+  Morse *timed = _timed;
+  if (timed && timed != this) return false;
+
+  byte head = _qhead;
+  byte next = (head + 1) & (MORSE_QUEUE_SIZE - 1);
+  if (next == _qtail) return false;
+  _queue[head] = c;
+  _qhead = next;
+
+#if defined(__AVR__) || defined(ARDUINO_NATIVE)
+  // Start right away if the sender is idle
+  noInterrupts();
+  if (!_playing) {
+    _next();
+    if (_playing) _timerStart();
   }
+  interrupts();
+#else
+  // No timer here, so send it the blocking way
+  _qtail = next;
+  send(c);
+#endif
+  return true;
 }
 
+byte Morse::queue(const char *str)
+{
+  byte n = 0;
+  while (*str && queue(*str++)) n++;
+  return n;
+}
+
+byte Morse::remaining()
+{
+  noInterrupts();
+  byte n = (_qhead - _qtail) & (MORSE_QUEUE_SIZE - 1);
+  if (_active) n++;
+  interrupts();
+  return n;
+}
+
+boolean Morse::done()
+{
+  return remaining() == 0;
+}
+
+void Morse::stop()
+{
+  noInterrupts();
+  _timerStop();
+  _qtail = _qhead;
+  _pc = 0;
+  _plen = 0;
+  _active = false;
+  if (_keyed) _key(false);
+  interrupts();
+}
 
+#if defined(__AVR__) && !defined(MORSE_NO_TIMER1_ISR)
+ISR(TIMER1_COMPA_vect)
+{
+  Morse::tick();
+}
+#endif
@@ -11,17 +11,73 @@
 #define Morse_h
 
 #include "Arduino.h"
+#include "MorseTiming.h"
+#include "FastPin.h"
+
+// Characters the timer driven sender can hold. Must be a power of two.
+#ifndef MORSE_QUEUE_SIZE
+#define MORSE_QUEUE_SIZE 16
+#endif
+
+// Outputs one Morse object can key together, see addOutput()
+#ifndef MORSE_MAX_OUTPUTS
+#define MORSE_MAX_OUTPUTS 3
+#endif
 
 class Morse
 {
 	public:
 		Morse(byte pin, byte speed, byte beep);
+		Morse(byte speed);	// no outputs yet, see addOutput()
+		~Morse();
+		boolean addOutput(byte pin, byte beep);	// key this one along, false if full
+
+		// Fixed-pin overloads: a key output on a pin known at compile time,
+		// written with a single sbi or cbi and no interrupt lock
+		template <uint8_t PIN> Morse(FastPin<PIN> pin, byte speed) : Morse(speed) { addOutput(pin); }
+		template <uint8_t PIN> boolean addOutput(FastPin<PIN>) {
+			if (!addOutput(PIN, 0)) return false;
+			_fixed[_outputs - 1] = _writeFixed<PIN>;
+			return true;
+		}
 		void sendmsg(char *str);
 		void send(char c);
+
+		// Non-blocking sending, timed from Timer1
+		byte queue(const char *str);	// returns the number of characters queued
+		boolean queue(char c);		// false if the queue is full or another Morse has Timer1
+		byte remaining();		// characters queued or still being sent
+		boolean done();
+		void stop();
+		void pitch(unsigned int hz);	// sidetone pitch in Hz, 400..1000
+		void farnsworth(byte wpm);	// space characters and words out to this overall speed
+		void trim(int permille);	// speed correction, permille/1000 faster
+		static void tick();		// Timer1 compare interrupt handler
 	private:
-		void dash();
-		void dit();
-		void bdash();
-		void bdit();
+		void _key(boolean on);
+		template <uint8_t PIN> static void _writeFixed(boolean on) { FastPin<PIN>::write(on); }
+		void _next();
+		void _timerStart();
+		void _timerStop();
+
+		byte _speed;	// Speed in WPM
+		MorseTiming _timing;	// Compiles characters to key timing
+		byte _outputs;	// Number of outputs keyed
+		byte _pin[MORSE_MAX_OUTPUTS];	// Pin to beep or toggle
+		byte _beep[MORSE_MAX_OUTPUTS];	// 2 == sine sidetone, 1 == beep to speaker, 0 == toggle pin high and low
+		MorsePin _port[MORSE_MAX_OUTPUTS];	// the pins toggled, written directly
+		void (*_fixed[MORSE_MAX_OUTPUTS])(boolean);	// or, for a FastPin, its write
+
+		// Timer driven sender, shared with the Timer1 interrupt
+		volatile char _queue[MORSE_QUEUE_SIZE];
+		volatile byte _qhead;	// written by queue() only
+		volatile byte _qtail;	// written by the interrupt only
+		uint16_t _prog[MORSE_TIMING_CHAR];	// timing of the character being sent
+		volatile byte _pc;	// next run of it
+		volatile byte _plen;
+		volatile boolean _playing;	// Timer1 is timing a run
+		volatile boolean _keyed;
+		volatile boolean _active;	// a character or its trailing space is being sent
+		static Morse * volatile _timed;	// the object Timer1 is sending for
 };
 #endif
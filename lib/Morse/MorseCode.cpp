@@ -0,0 +1,27 @@
+//
+// Morse code tables, generated at compile time from MORSE_CODES
+//
+// Released under GPLv3
+//
+
+#include "MorseCode.h"
+
+#define MORSE_R4(f, n) f(n), f(n + 1), f(n + 2), f(n + 3)
+#define MORSE_R16(f, n) MORSE_R4(f, n), MORSE_R4(f, n + 4), MORSE_R4(f, n + 8), MORSE_R4(f, n + 12)
+#define MORSE_R32(f, n) MORSE_R16(f, n), MORSE_R16(f, n + 16)
+
+const uint8_t morseEncodeTable[96] PROGMEM = {
+  MORSE_R32(morseEncodeOf, 32), MORSE_R32(morseEncodeOf, 64), MORSE_R32(morseEncodeOf, 96)
+};
+
+const char morseDecodeTable[256] PROGMEM = {
+  MORSE_R32(morseDecodeOf, 0), MORSE_R32(morseDecodeOf, 32),
+  MORSE_R32(morseDecodeOf, 64), MORSE_R32(morseDecodeOf, 96),
+  MORSE_R32(morseDecodeOf, 128), MORSE_R32(morseDecodeOf, 160),
+  MORSE_R32(morseDecodeOf, 192), MORSE_R32(morseDecodeOf, 224)
+};
+
+// The sender and the decoder rely on these staying put
+static_assert(morsePack(".-") == 6, "first element in bit 0");
+static_assert(morseEncodeOf('a') == morseEncodeOf('A'), "lowercase folded");
+static_assert(morseDecodeOf(morseEncodeOf('?')) == '?', "tables agree");
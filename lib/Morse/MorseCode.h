@@ -0,0 +1,103 @@
+//
+// Morse code table shared by Morse (sender) and MorseEnDecoder
+//
+// Released under GPLv3
+//
+// Every code is listed once below. The compiler packs each one into a
+// byte and builds two flash tables from the list:
+//
+//   morseEncodeTable  ASCII 32..127 -> packed code, lowercase folded
+//   morseDecodeTable  packed code   -> ASCII, '*' for unknown codes
+//
+// Packed form ("reverse binary", as sent by Morse): the first element is
+// in bit 0, 1 == dash, 0 == dot, and a 1 bit above the last element marks
+// the end. So "A" .- is 0b110 and a code without elements (space or an
+// unknown character) is 1. Up to 7 elements fit in a byte.
+
+#ifndef MorseCode_h
+#define MorseCode_h
+
+#include <stdint.h>
+
+// No Arduino.h here, so host tools can use the tables too
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#else
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+#ifndef pgm_read_byte
+#define pgm_read_byte(addr) (*(const unsigned char *)(addr))
+#endif
+#endif
+
+#define MORSE_CODES(X) \
+  X('A', ".-")      X('B', "-...")    X('C', "-.-.")    X('D', "-..") \
+  X('E', ".")       X('F', "..-.")    X('G', "--.")     X('H', "....") \
+  X('I', "..")      X('J', ".---")    X('K', "-.-")     X('L', ".-..") \
+  X('M', "--")      X('N', "-.")      X('O', "---")     X('P', ".--.") \
+  X('Q', "--.-")    X('R', ".-.")     X('S', "...")     X('T', "-") \
+  X('U', "..-")     X('V', "...-")    X('W', ".--")     X('X', "-..-") \
+  X('Y', "-.--")    X('Z', "--..") \
+  X('0', "-----")   X('1', ".----")   X('2', "..---")   X('3', "...--") \
+  X('4', "....-")   X('5', ".....")   X('6', "-....")   X('7', "--...") \
+  X('8', "---..")   X('9', "----.") \
+  X('!', "-.-.--")  X('"', ".-..-.")  X('$', "...-..-") X('&', ".-...") \
+  X('\'', ".----.") X('(', "-.--.")   X(')', "-.--.-")  X('+', ".-.-.") \
+  X(',', "--..--")  X('-', "-....-")  X('.', ".-.-.-")  X('/', "-..-.") \
+  X(':', "---...")  X(';', "-.-.-.")  X('=', "-...-")   X('?', "..--..") \
+  X('@', ".--.-.")  X('\\', "......") X('_', "..--.-")
+
+// Extra spellings understood in one direction only
+#define MORSE_ENCODE_ALIASES(X) \
+  X('`', ".----.")
+#define MORSE_DECODE_ALIASES(X) \
+  X('!', "---.")    /* MN digraph */
+
+constexpr uint8_t morsePack(const char *code)
+{
+  return *code ? (uint8_t)((*code == '-') | (morsePack(code + 1) << 1)) : 1;
+}
+
+#define MORSE_ENCODE_CASE(c, code) ch == (c) ? morsePack(code) :
+#define MORSE_DECODE_CASE(c, code) packed == morsePack(code) ? (c) :
+
+constexpr uint8_t morseEncodeOf(char ch)
+{
+  return (ch >= 'a' && ch <= 'z') ? morseEncodeOf(ch - 'a' + 'A') :
+    MORSE_CODES(MORSE_ENCODE_CASE) MORSE_ENCODE_ALIASES(MORSE_ENCODE_CASE) 1;
+}
+
+constexpr char morseDecodeOf(uint8_t packed)
+{
+  return packed == 1 ? ' ' :
+    MORSE_CODES(MORSE_DECODE_CASE) MORSE_DECODE_ALIASES(MORSE_DECODE_CASE) '*';
+}
+
+extern const uint8_t morseEncodeTable[96] PROGMEM;
+extern const char morseDecodeTable[256] PROGMEM;
+
+// Packed code of c, 1 if it has none
+inline uint8_t morseEncode(char c)
+{
+  uint8_t i = (uint8_t)c - 32;
+  return i < 96 ? pgm_read_byte(&morseEncodeTable[i]) : 1;
+}
+
+inline char morseDecode(uint8_t packed)
+{
+  return pgm_read_byte(&morseDecodeTable[packed]);
+}
+
+// Number of dots and dashes in a packed code
+inline uint8_t morseLength(uint8_t packed)
+{
+  uint8_t n = 0;
+  while (packed > 1) {
+    packed >>= 1;
+    n++;
+  }
+  return n;
+}
+
+#endif
@@ -0,0 +1,127 @@
+//
+// Keying speed meter for the Morse library
+//
+// Released under GPLv3
+//
+// Marks up to two dots are dots, gaps up to two dots element gaps, and
+// gaps up to five spacing units (halfway between 3 and 7) character gaps.
+// Each sum is halved with its count before it can overflow, so a long
+// run keeps averaging.
+
+#include "Arduino.h"
+#include "MorseMeter.h"
+
+#define METER_WORD 0
+#define METER_DOT 1
+#define METER_CHAR 2
+#define METER_SPACE 3
+
+MorseMeter::MorseMeter()
+{
+  begin(20, 0);
+}
+
+void MorseMeter::begin(byte wpm, byte effectiveWpm)
+{
+  unsigned long c = wpm ? wpm : 1;
+  unsigned long s = effectiveWpm;
+  if (!s || s >= c) s = c;
+
+  // Spacing unit (60 c - 37.2 s) / (19 s c) s, see MorseTiming.cpp
+  _target = s;
+  _dotMax = 2 * 1200000UL / c;
+  _charMax = 5 * ((600 * c - 372 * s) * 5263UL / (s * c));
+
+  _started = false;
+  _newWord = true;
+  _counting = false;
+  for (byte i = 0; i < 4; i++) {
+    _sum[i] = 0;
+    _n[i] = 0;
+  }
+}
+
+void MorseMeter::_add(unsigned long *sum, unsigned int *n, unsigned long t)
+{
+  if (*sum > 0x7FFFFFFFUL - t || *n == 0xFFFF) {
+    *sum /= 2;
+    *n /= 2;
+  }
+  *sum += t;
+  ++*n;
+}
+
+void MorseMeter::edge(boolean down, unsigned long time)
+{
+  if (_started && down == _down) return;
+  unsigned long t = time - _last;
+  _last = time;
+  _down = down;
+  if (!_started) {
+    // The first edge only starts the clock, and the first mark a word
+    _started = true;
+  } else if (!down) {
+    // End of a mark
+    if (t < _dotMax) _add(&_sum[METER_DOT], &_n[METER_DOT], t);
+  } else if (t >= _charMax) {
+    // End of a gap
+    _add(&_sum[METER_SPACE], &_n[METER_SPACE], t);
+    _newWord = true;
+  } else if (t >= _dotMax) {
+    _add(&_sum[METER_CHAR], &_n[METER_CHAR], t);
+  }
+
+  if (down && _newWord) {
+    // First mark of a word
+    if (_counting) _add(&_sum[METER_WORD], &_n[METER_WORD], time - _wordStart);
+    _wordStart = time;
+    _counting = true;
+    _newWord = false;
+  }
+}
+
+unsigned long MorseMeter::_average(unsigned long sum, unsigned int n)
+{
+  return n ? (sum + n / 2) / n : 0;
+}
+
+unsigned int MorseMeter::words()
+{
+  return _n[METER_WORD];
+}
+
+unsigned long MorseMeter::period()
+{
+  return _average(_sum[METER_WORD], _n[METER_WORD]);
+}
+
+unsigned long MorseMeter::wpm100()
+{
+  unsigned long t = (period() + 5) / 10;
+  return t ? (600000000UL + t / 2) / t : 0;
+}
+
+unsigned long MorseMeter::dot()
+{
+  return _average(_sum[METER_DOT], _n[METER_DOT]);
+}
+
+unsigned long MorseMeter::charGap()
+{
+  return _average(_sum[METER_CHAR], _n[METER_CHAR]);
+}
+
+unsigned long MorseMeter::wordGap()
+{
+  return _average(_sum[METER_SPACE], _n[METER_SPACE]);
+}
+
+int MorseMeter::trim(int current)
+{
+  unsigned long t = period();
+  if (!t) return current;
+  // Speed goes with 1000 + trim, the word period with its inverse
+  unsigned long exact = 600000UL / _target;	// exact period / 100
+  long ratio = (t * 10 + exact / 2) / exact;	// 1000 t / exact period
+  return ((1000L + current) * ratio + 500) / 1000 - 1000;
+}
@@ -0,0 +1,52 @@
+//
+// Keying speed meter for the Morse library
+//
+// Released under GPLv3
+//
+// Measures keying from its edges: the speed from the time between the
+// starts of successive words (PARIS takes 60 / WPM seconds), and the
+// average dot, character gap and word gap. Feed it edges timestamped as
+// they happen, e.g. from the pin change capture of morseDecoder.
+//
+// Usage:
+//         MorseMeter m;
+//         m.begin(25, 15);	expect 25 WPM characters, 15 WPM spacing
+//         m.edge(true, micros());	key down
+//         if (m.words()) Serial.println(m.wpm100());
+//
+
+#ifndef MorseMeter_h
+#define MorseMeter_h
+
+#include "Arduino.h"
+
+class MorseMeter
+{
+	public:
+		MorseMeter();
+		void begin(byte wpm, byte effectiveWpm);	// the speed sent, sorts out the gaps
+		void edge(boolean down, unsigned long time);	// key down or up at time, us
+		unsigned int words();		// word periods measured
+		unsigned long period();		// average word period, us
+		unsigned long wpm100();		// speed in 1/100 WPM
+		unsigned long dot();		// average dot, us
+		unsigned long charGap();
+		unsigned long wordGap();
+		int trim(int current);		// Morse::trim() that sends the expected speed
+	private:
+		static unsigned long _average(unsigned long sum, unsigned int n);
+		static void _add(unsigned long *sum, unsigned int *n, unsigned long t);
+
+		byte _target;		// expected overall speed
+		unsigned long _dotMax;	// longer marks are dashes, shorter gaps element gaps
+		unsigned long _charMax;	// longer gaps are word gaps
+		boolean _down;
+		boolean _started;	// an edge was seen, the time below is valid
+		boolean _newWord;	// the gap before the next mark was a word gap
+		boolean _counting;	// a word start was seen
+		unsigned long _last;	// time of the last edge
+		unsigned long _wordStart;
+		unsigned long _sum[4];	// word periods, dots, character gaps, word gaps
+		unsigned int _n[4];
+};
+#endif
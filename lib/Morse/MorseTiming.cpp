@@ -0,0 +1,169 @@
+//
+// Text to key timing compiler for the Morse library
+//
+// Released under GPLv3
+//
+// Dots last 1.2 s / WPM. Every run is added to the exact time in whole us
+// plus a fraction, and only rounded to ticks as it is written, so rounding
+// never adds up: at 35 WPM the dot is 34285.7 us, not 34 ms.
+//
+// Spacing follows the ARRL Farnsworth method. Characters go at the
+// character speed c, and the gaps between them (3 units) and between words
+// (7 units) use a longer unit, so that PARIS takes 60 / s seconds at the
+// effective speed s:
+//
+//   unit = (60 c - 37.2 s) / (19 s c) seconds
+//
+// Without Farnsworth spacing the unit is the dot.
+//
+// A speed trim from setTrim() scales every length by 1000 / (1000 + trim),
+// to correct a sender measured fast or slow. It is applied to the exact
+// lengths, so it costs nothing while compiling.
+
+#include "Arduino.h"
+#include "MorseTiming.h"
+#include "MorseCode.h"
+
+MorseTiming::MorseTiming()
+{
+  _trim = 0;
+  setSpeed(20, 0);
+}
+
+void MorseTiming::setTrim(int permille)
+{
+  _trim = constrain(permille, -MORSE_TIMING_MAX_TRIM, MORSE_TIMING_MAX_TRIM);
+  setSpeed(_wpm, _effectiveWpm);
+}
+
+void MorseTiming::setSpeed(byte wpm, byte effectiveWpm)
+{
+  _wpm = wpm;
+  _effectiveWpm = effectiveWpm;
+
+  unsigned long c = wpm ? wpm : 1;
+  unsigned long s = effectiveWpm;
+  if (!s || s >= c) s = c;
+  if (s < MORSE_TIMING_MIN_WPM && c > MORSE_TIMING_MIN_WPM) s = MORSE_TIMING_MIN_WPM;
+
+  _dotUs = 1200000UL / c;
+  if (s == c) {
+    _den = c;
+    _dotFrac = 1200000UL % c;
+    _unitUs = _dotUs;
+    _unitFrac = _dotFrac;
+  } else {
+    // unit = 100000 (600 c - 372 s) / den us, in two steps to stay in 32 bits
+    _den = 19 * s * c;
+    _dotFrac = (1200000UL % c) * 19 * s;
+    unsigned long x = 1000 * (600 * c - 372 * s);
+    unsigned long r = x % _den;
+    _unitUs = 100 * (x / _den) + 100 * r / _den;
+    _unitFrac = (100 * r) % _den;
+  }
+  if (_trim) {
+    _scale(&_dotUs, &_dotFrac);
+    _scale(&_unitUs, &_unitFrac);
+  }
+  restart();
+}
+
+// us + frac / _den times 1000 / (1000 + _trim), to within 1/1000 us
+void MorseTiming::_scale(unsigned long *us, unsigned long *frac)
+{
+  unsigned long k = 1000 + _trim;
+  unsigned long t = *us * 1000 + *frac * 1000 / _den;
+  *us = t / k;
+  *frac = (t % k) * _den / k;
+}
+
+void MorseTiming::restart()
+{
+  _frac = 0;
+  _owed = 0;
+}
+
+unsigned long MorseTiming::duration(uint16_t entry)
+{
+  return (unsigned long)(entry & MORSE_TIMING_MAX) * MORSE_TIMING_TICK_US;
+}
+
+// Add units of dots, or of spacing, to the program at n. Returns the new
+// length, -1 if it doesn't fit.
+int MorseTiming::_run(boolean mark, byte units, boolean spacing, uint16_t *prog, int n, int size)
+{
+  _owed += units * (spacing ? _unitUs : _dotUs);
+  _frac += units * (spacing ? _unitFrac : _dotFrac);
+  while (_frac >= _den) {
+    _frac -= _den;
+    _owed++;
+  }
+
+  unsigned long ticks = (unsigned long)(_owed + MORSE_TIMING_TICK_US / 2) / MORSE_TIMING_TICK_US;
+  _owed -= ticks * MORSE_TIMING_TICK_US;
+
+  uint16_t state = mark ? MORSE_TIMING_MARK : 0;
+  while (ticks) {
+    uint16_t len;
+    if (n > 0 && (prog[n - 1] & MORSE_TIMING_MARK) == state && (prog[n - 1] & MORSE_TIMING_MAX) < MORSE_TIMING_MAX) {
+      // Lengthen the last run, a word gap after a character gap
+      len = MORSE_TIMING_MAX - (prog[n - 1] & MORSE_TIMING_MAX);
+      if (len > ticks) len = ticks;
+      prog[n - 1] += len;
+    } else {
+      if (n == size) return -1;
+      len = ticks > MORSE_TIMING_MAX ? MORSE_TIMING_MAX : ticks;
+      prog[n++] = state | len;
+    }
+    ticks -= len;
+  }
+  return n;
+}
+
+int MorseTiming::_append(char c, uint16_t *prog, int n, int size)
+{
+  byte code = morseEncode(c);
+
+  if (code == 1) {
+    // A word gap is 7 units, 3 of them went after the last character
+    if (c == ' ') n = _run(false, 4, true, prog, n, size);
+    return n;
+  }
+
+  while (code > 1 && n >= 0) {
+    n = _run(true, (code & 1) ? 3 : 1, false, prog, n, size);
+    code >>= 1;
+    if (n < 0) break;
+    if (code > 1)
+      n = _run(false, 1, false, prog, n, size);	// element gap
+    else
+      n = _run(false, 3, true, prog, n, size);	// character gap
+  }
+  return n;
+}
+
+byte MorseTiming::compile(char c, uint16_t *prog, byte size)
+{
+  unsigned long frac = _frac;
+  long owed = _owed;
+  int n = _append(c, prog, 0, size);
+  if (n < 0) {
+    _frac = frac;
+    _owed = owed;
+    return 0;
+  }
+  return n;
+}
+
+int MorseTiming::compile(const char *text, uint16_t *prog, int size)
+{
+  unsigned long frac = _frac;
+  long owed = _owed;
+  int n = 0;
+  while (*text && n >= 0) n = _append(*text++, prog, n, size);
+  if (n < 0) {
+    _frac = frac;
+    _owed = owed;
+  }
+  return n;
+}
@@ -0,0 +1,62 @@
+//
+// Text to key timing compiler for the Morse library
+//
+// Released under GPLv3
+//
+// A timing program is a list of runs of key down or key up time, one
+// uint16_t each: MORSE_TIMING_MARK for key down, and the length in
+// MORSE_TIMING_TICK_US steps. Morse plays them from Timer1, or with
+// micros() in the blocking send().
+//
+// Usage:
+//         MorseTiming t;
+//         t.setSpeed(25, 15);	25 WPM characters, 15 WPM Farnsworth spacing
+//         n = t.compile("PARIS ", prog, size);
+//
+
+#ifndef MorseTiming_h
+#define MorseTiming_h
+
+#include "Arduino.h"
+
+#define MORSE_TIMING_MARK 0x8000	// key down
+#define MORSE_TIMING_MAX 0x7FFF	// longest run one entry holds, in ticks
+#define MORSE_TIMING_TICK_US (1024000000UL / F_CPU)	// one Timer1 count at clk/1024, 64 us at 16 MHz
+
+// Entries one character and the gap after it can take
+#define MORSE_TIMING_CHAR 16
+
+// Lowest Farnsworth speed, slower spacing could overflow MORSE_TIMING_CHAR
+#define MORSE_TIMING_MIN_WPM 5
+
+// Largest speed trim, in 1/1000
+#define MORSE_TIMING_MAX_TRIM 100
+
+class MorseTiming
+{
+	public:
+		MorseTiming();
+		void setSpeed(byte wpm, byte effectiveWpm);	// effectiveWpm 0 or >= wpm: no Farnsworth spacing
+		void setTrim(int permille);	// send permille/1000 faster (or slower if < 0)
+		void restart();		// forget the rounding carried over from the last run
+		byte compile(char c, uint16_t *prog, byte size);	// c and its gap, 0 entries if they don't fit
+		int compile(const char *text, uint16_t *prog, int size);	// -1 if it doesn't fit
+		static unsigned long duration(uint16_t entry);	// in us
+	private:
+		int _append(char c, uint16_t *prog, int n, int size);
+		int _run(boolean mark, byte units, boolean spacing, uint16_t *prog, int n, int size);
+		void _scale(unsigned long *us, unsigned long *frac);
+
+		byte _wpm;			// as given to setSpeed()
+		byte _effectiveWpm;
+		int _trim;			// speed trim, 1/1000
+
+		unsigned long _den;		// denominator of the fractions below
+		unsigned long _dotUs;		// dot length, whole us ...
+		unsigned long _dotFrac;		// ... and fraction
+		unsigned long _unitUs;		// spacing unit between characters and words
+		unsigned long _unitFrac;
+		unsigned long _frac;		// fraction of a us owed
+		long _owed;			// us the runs written are behind the exact time
+};
+#endif
@@ -0,0 +1,159 @@
+//
+// Sine sidetone for the Morse library
+//
+// Released under GPLv3
+//
+// Direct digital synthesis: a 16 bit phase advances by _step every sample,
+// its top byte picks the sample from a quarter wave table, and the envelope
+// position picks the gain from a raised cosine ramp. Both tables are in
+// flash. The interrupt only runs while the tone is keyed or ramping down;
+// in between the output rests at its mid level.
+//
+// Each sample costs about 100 cycles including the interrupt entry and
+// exit, or 20% of the CPU while the tone sounds and none otherwise.
+
+#include "Arduino.h"
+#include "Sidetone.h"
+
+// Envelope steps per sample for a SIDETONE_RAMP_MS long ramp
+#define SIDETONE_RAMP_STEP (65536UL * 1000UL / (SIDETONE_RATE * SIDETONE_RAMP_MS))
+
+// sin(0..90 degrees) * 127
+static const int8_t _quarterSine[65] PROGMEM = {
+    0,   3,   6,   9,  12,  16,  19,  22,  25,  28,  31,  34,  37,  40,  43,  46,
+   49,  51,  54,  57,  60,  63,  65,  68,  71,  73,  76,  78,  81,  83,  85,  88,
+   90,  92,  94,  96,  98, 100, 102, 104, 106, 107, 109, 111, 112, 113, 115, 116,
+  117, 118, 120, 121, 122, 122, 123, 124, 125, 125, 126, 126, 126, 127, 127, 127,
+  127
+};
+
+// (1 - cos(0..180 degrees)) / 2 * 255
+static const byte _ramp[64] PROGMEM = {
+    0,   0,   1,   1,   3,   4,   6,   8,  10,  13,  16,  19,  22,  26,  30,  34,
+   38,  43,  48,  53,  58,  64,  69,  75,  81,  87,  93,  99, 105, 112, 118, 124,
+  131, 137, 143, 150, 156, 162, 168, 174, 180, 186, 191, 197, 202, 207, 212, 217,
+  221, 225, 229, 233, 236, 239, 242, 245, 247, 249, 251, 252, 254, 254, 255, 255
+};
+
+static byte _pin;
+static uint16_t _phase;
+static volatile uint16_t _step;		// phase increment per sample, sets the pitch
+static volatile uint16_t _env = 0;	// position on the ramp, 0 == silent, 0xFFFF == full
+static volatile boolean _on = false;	// ramping up (keyed) or down
+static volatile boolean _running = false;
+
+#ifdef __AVR__
+static void _level(byte level)
+{
+  // Only the pin given to begin() has its compare output enabled
+  OCR2A = level;
+  OCR2B = level;
+}
+#endif
+
+void Sidetone::begin(byte pin, unsigned int hz)
+{
+  _pin = pin;
+  pitch(hz);
+  pinMode(_pin, OUTPUT);
+
+#ifdef __AVR__
+  TIMSK2 = 0;
+  TCCR2B = 0;
+  TCNT2 = 0;
+  _level(0);
+  // Phase correct PWM, TOP 0xFF, non-inverting on the chosen pin, clk/1
+  TCCR2A = (_pin == 11 ? _BV(COM2A1) : _BV(COM2B1)) | _BV(WGM20);
+  TCCR2B = _BV(CS20);
+
+  // Bring the output up to its resting level slowly, so that doesn't click either
+  for (int l = 1; l <= 128; l++) {
+    _level(l);
+    delayMicroseconds(40);
+  }
+#endif
+}
+
+void Sidetone::pitch(unsigned int hz)
+{
+  hz = constrain(hz, SIDETONE_MIN_HZ, SIDETONE_MAX_HZ);
+  uint16_t step = ((uint32_t)hz * 65536UL + SIDETONE_RATE / 2) / SIDETONE_RATE;
+  noInterrupts();
+  _step = step;
+  interrupts();
+}
+
+void Sidetone::key(boolean on)
+{
+  noInterrupts();
+  _on = on;
+  if (on && !_running) {
+    _running = true;
+#ifdef __AVR__
+    TIFR2 = _BV(TOV2);
+    TIMSK2 = _BV(TOIE2);
+#endif
+  }
+  interrupts();
+#ifndef __AVR__
+  analogWrite(_pin, on ? 128 : 0);	// let the native build see the keying
+#endif
+}
+
+boolean Sidetone::sounding()
+{
+  return _running;
+}
+
+void Sidetone::end()
+{
+  key(false);
+  while (_running) {
+#ifndef __AVR__
+    tick();
+#endif
+  }
+
+#ifdef __AVR__
+  for (int l = 127; l >= 0; l--) {
+    _level(l);
+    delayMicroseconds(40);
+  }
+  TCCR2A = 0;
+  TCCR2B = 0;
+#endif
+  digitalWrite(_pin, LOW);
+}
+
+byte Sidetone::tick()
+{
+  uint16_t env = _env;
+  if (_on) {
+    env = (env < 0xFFFF - SIDETONE_RAMP_STEP) ? env + SIDETONE_RAMP_STEP : 0xFFFF;
+  } else if (env > SIDETONE_RAMP_STEP) {
+    env -= SIDETONE_RAMP_STEP;
+  } else {
+    // Released, rest at the mid level until keyed again
+    _env = 0;
+    _running = false;
+#ifdef __AVR__
+    TIMSK2 = 0;
+#endif
+    return 128;
+  }
+  _env = env;
+
+  _phase += _step;
+  byte i = _phase >> 8;
+  byte j = i & 63;
+  int8_t s = pgm_read_byte(&_quarterSine[(i & 64) ? 64 - j : j]);
+  if (i & 128) s = -s;
+  return 128 + (((int16_t)s * pgm_read_byte(&_ramp[env >> 10]) + 128) >> 8);
+}
+
+#if defined(__AVR__) && !defined(MORSE_NO_TIMER2_ISR)
+ISR(TIMER2_OVF_vect)
+{
+  _level(Sidetone::tick());
+}
+#endif
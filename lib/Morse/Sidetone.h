@@ -0,0 +1,44 @@
+//
+// Sine sidetone for the Morse library
+//
+// Released under GPLv3
+//
+// Timer2 runs in phase correct PWM at F_CPU/510 (31.4 kHz) on OC2B (pin 3)
+// or OC2A (pin 11). Every overflow interrupt steps a phase accumulator
+// through a sine table and scales the sample by a raised cosine envelope,
+// so the tone starts and stops without clicks. Feed the speaker through a
+// capacitor; a 1k/100nF low pass in front of it takes out the carrier.
+//
+// Usage:
+//         Sidetone::begin(3, 700);
+//         Sidetone::key(true);	ramps up, sounds until key(false)
+//
+
+#ifndef Sidetone_h
+#define Sidetone_h
+
+#include "Arduino.h"
+
+// Pitch range, Hz
+#define SIDETONE_MIN_HZ 400
+#define SIDETONE_MAX_HZ 1000
+
+// Attack and release time, ms
+#ifndef SIDETONE_RAMP_MS
+#define SIDETONE_RAMP_MS 5
+#endif
+
+// Samples per second, one per Timer2 overflow
+#define SIDETONE_RATE (F_CPU / 510UL)
+
+class Sidetone
+{
+	public:
+		static void begin(byte pin, unsigned int hz);	// pin 3 or 11
+		static void pitch(unsigned int hz);
+		static void key(boolean on);
+		static boolean sounding();	// keyed or still ramping down
+		static void end();
+		static byte tick();		// next PWM level, Timer2 overflow interrupt handler
+};
+#endif
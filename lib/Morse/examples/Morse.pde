@@ -15,7 +15,8 @@ Morse morse(9, 12, 1);
 
 void setup()
 {
-  // Nothing here for the Morse lib
+  // Uncomment to flash the LED along with the speaker
+  // morse.addOutput(13, 0);
 }
 
 void loop()
@@ -0,0 +1,140 @@
+// Pin access benchmark
+// Released under GPLv3
+//
+// Counts CPU cycles with Timer1 at clk/1 and prints, at 9600 baud:
+//  - cycles per pin write and read: digitalWrite()/digitalRead(),
+//    MorsePin and FastPin<>
+//  - how often morseDecoder::decode() can poll a keyer, calls per second
+//    and cycles per call, with the pin given at run time and fixed
+//  - software I2C throughput to an SSD1306 on pins A4/A5, bytes per second
+//
+// Build it twice to compare before and after, the second time with
+// -D MORSE_NO_FAST_PIN -D U8X8_NO_AVR_FAST_GPIO. MorsePin, FastPin<> and
+// so decode() then go through digitalRead() as they did before, and the
+// software I2C through pinMode() and digitalWrite(). Runs on an ATmega328
+// at 16 MHz, with or without the display connected (without it the bytes
+// go nowhere, at the same speed). Timer1 is taken over, so no Morse
+// object may be sending.
+//
+// No results yet: neither build has been run on a board or in a
+// simulator, so the before and after figures are still owed.
+
+#include <Morse.h>
+#include <MorseEnDecoder.h>
+#include <U8x8lib.h>
+
+const byte out_pin = 13;
+const byte in_pin = 4;
+const int loops = 500;	// up to 131 cycles per call fit 16 bits
+
+U8X8_SSD1306_128X32_UNIVISION_SW_I2C oled(A5, A4);
+
+// Cycles per pass of the empty loop, taken off every result
+unsigned int overhead;
+
+void timerStart()
+{
+  TCCR1A = 0;
+  TCCR1B = 0;
+  TCNT1 = 0;
+  TCCR1B = _BV(CS10);	// clk/1, counts cycles
+}
+
+unsigned int timerCycles()
+{
+  unsigned int t = TCNT1;
+  TCCR1B = 0;
+  return t;
+}
+
+// Time 'loops' passes of body, in cycles per pass, with interrupts off so
+// millis() doesn't land in the middle
+#define BENCH(body) ({ \
+  noInterrupts(); \
+  timerStart(); \
+  for (volatile int i = 0; i < loops / 10; i++) { body; body; body; body; body; body; body; body; body; body; } \
+  unsigned int t = timerCycles(); \
+  interrupts(); \
+  (float)t / loops; \
+})
+
+void report(const char *what, float cycles)
+{
+  Serial.print(what);
+  Serial.print(cycles - overhead / 10.0, 1);
+  Serial.println(" cycles");
+}
+
+void reportPolls(const char *what, unsigned long n)
+{
+  Serial.print(what);
+  Serial.print(n);
+  Serial.print(" per second, ");
+  Serial.print(F_CPU / n);
+  Serial.println(" cycles each");
+}
+
+void setup()
+{
+  Serial.begin(9600);
+  pinMode(out_pin, OUTPUT);
+  pinMode(in_pin, INPUT_PULLUP);
+
+  MorsePin out;
+  MorsePin in;
+  out.attach(out_pin);
+  in.attach(in_pin);
+  volatile boolean level;
+
+  overhead = BENCH(;) * 10;
+  Serial.println("Pin access, per call:");
+  report("  digitalWrite   ", BENCH(digitalWrite(out_pin, HIGH)));
+  report("  MorsePin write ", BENCH(out.write(true)));
+  report("  FastPin write  ", BENCH(FastPin<out_pin>::write(true)));
+  report("  digitalRead    ", BENCH(level = digitalRead(in_pin)));
+  report("  MorsePin read  ", BENCH(level = in.read()));
+  report("  FastPin read   ", BENCH(level = FastPin<in_pin>::read()));
+  (void)level;
+
+  // Keyer polling, as in the decoder screen without edge capture
+  morseDecoder keyer(in_pin, MORSE_KEYER, MORSE_ACTIVE_LOW);
+  unsigned long n = 0;
+  unsigned long t = millis();
+  while (millis() - t < 1000) {
+    keyer.decode();
+    n++;
+  }
+#ifdef MORSE_NO_FAST_PIN
+  reportPolls("decode() polls, digitalRead(): ", n);
+#else
+  reportPolls("decode() polls, MorsePin: ", n);
+#endif
+  n = 0;
+  t = millis();
+  while (millis() - t < 1000) {
+    keyer.decode(FastPin<in_pin>());
+    n++;
+  }
+#ifdef MORSE_NO_FAST_PIN
+  reportPolls("decode(FastPin) polls, digitalRead(): ", n);
+#else
+  reportPolls("decode(FastPin) polls: ", n);
+#endif
+
+  // Software I2C: one full 128x32 screen is 4 rows of 16 tiles of 8 bytes
+  oled.begin();
+  uint8_t tiles[16 * 8];
+  memset(tiles, 0x55, sizeof(tiles));
+  t = micros();
+  for (byte k = 0; k < 4; k++)
+    for (byte row = 0; row < 4; row++)
+      oled.drawTile(0, row, 16, tiles);
+  t = micros() - t;
+  Serial.print("Software I2C: ");
+  Serial.print(4UL * 4 * sizeof(tiles) * 1000000UL / t);
+  Serial.println(" bytes per second");
+}
+
+void loop()
+{
+}
@@ -43,26 +43,7 @@
 
 
 #include "MorseEnDecoder.h"
-
-
-
-// character index position of the binary morse tree top.
-//const int morseTreetop = 31;   // This is for ITU international Morse Code (no punctuation)
-const int morseTreetop = 63;   // This is for ITU with puncutation, but without non-english extensions
-
-const int morseTableLength = (morseTreetop*2)+1;
-const int morseTreeLevels = log(morseTreetop+1)/log(2);
-
-
-// Morse code binary tree table (or, dichotomic search table)
-// TODO: have this table in PROGMEM!
-
-// ITU - International Morse code table only
-//char morseTable[] = "5H4S?V3I?F?U??2E?L?R???A?P?W?J1 6B?D?X?N?C?K?Y?T7Z?G?Q?M8??O9?0";
-
-// This is the table for ITU with punctuation (but without non-english characters - for now)
-char morseTable[] = "*5*H*4*S***V*3*I***F***U?*_**2*E***L\"**R*+.****A***P@**W***J'1* *6-B*=*D*/"
-                    "*X***N***C;*!K*()Y***T*7*Z**,G***Q***M:8*!***O*9***0*";
+#include <MorseCode.h>
 
 
 
@@ -76,57 +57,345 @@ morseDecoder::morseDecoder(int decodePin, boolean listenAudio, boolean morsePull
   {
     pinMode(morseInPin, INPUT);
     if (activeLow) digitalWrite (morseInPin, HIGH);
+    keyerPin.attach(morseInPin);
   }
 
   // Some initial values  
-  wpm = 13;
   AudioThreshold = 700;
-  debounceDelay = 20;
-  dotTime = 1200 / wpm;       // morse dot time length in ms
-  dashTime = 3 * 1200 / wpm;
-  wordSpace = 7 * 1200 / wpm;
-
-  morseTableJumper = (morseTreetop+1)/2;
-  morseTablePointer = morseTreetop;
+  debounceDelay = 10;
  
   morseKeyer = LOW;
   morseSignalState = LOW;
-  lastKeyerState = LOW;
+  keyerIntegral = 0;
+  keyerTime = 0;
 
-  gotLastSig = true;
-  morseSpace = true;
-  decodedMorseChar = '\0';
-  
   lastDebounceTime = 0;
-  markTime = 0;
-  spaceTime = 0;
+
+  edgeOverflows = 0;
+  edgeHighWater = 0;
+
+  sampleOverflows = 0;
+  toneState = false;
+}
+
+
+
+morseDecoder::~morseDecoder()
+{
+  endCapture();
+  endTone();
+}
+
+
+
+morseDecoder * volatile morseDecoder::captureDecoder = 0;
+volatile boolean morseDecoder::captureLevel = LOW;
+volatile byte morseDecoder::edgeHead = 0;
+volatile byte morseDecoder::edgeTail = 0;
+volatile unsigned long morseDecoder::edgeTime[MORSE_EDGE_BUFFER_SIZE];
+volatile boolean morseDecoder::edgeLevel[MORSE_EDGE_BUFFER_SIZE];
+
+boolean morseDecoder::beginCapture()
+{
+#ifdef __AVR__
+  // Only a keyer input on a pin with a pin change interrupt can be captured
+  if (morseAudio || digitalPinToPCICR(morseInPin) == 0) return false;
+
+  endCapture();
+  if (captureDecoder) captureDecoder->endCapture();
+
+  edgeHead = 0;
+  edgeTail = 0;
+  captureLevel = keyerPin.read() ? HIGH : LOW;
+  morseKeyer = activeLow ? !captureLevel : captureLevel;
+  keyerTime = micros();
+
+  uint8_t oldSREG = SREG;
+  cli();
+  captureDecoder = this;
+  *digitalPinToPCMSK(morseInPin) |= _BV(digitalPinToPCMSKbit(morseInPin));
+  *digitalPinToPCICR(morseInPin) |= _BV(digitalPinToPCICRbit(morseInPin));
+  SREG = oldSREG;
+  return true;
+#elif defined(ARDUINO_NATIVE)
+  // The native build calls captureEdge() itself when the pin is written
+  if (morseAudio) return false;
+
+  endCapture();
+  if (captureDecoder) captureDecoder->endCapture();
+
+  edgeHead = 0;
+  edgeTail = 0;
+  captureLevel = nativePinLevel(morseInPin);
+  morseKeyer = activeLow ? !captureLevel : captureLevel;
+  keyerTime = micros();
+
+  captureDecoder = this;
+  if (!nativePinChange(morseInPin, captureEdge))
+  {
+    captureDecoder = 0;
+    return false;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+
+
+void morseDecoder::endCapture()
+{
+  if (captureDecoder != this) return;
+#ifdef __AVR__
+  uint8_t oldSREG = SREG;
+  cli();
+  // Leave PCICR alone, other pins of the port may still use it
+  *digitalPinToPCMSK(morseInPin) &= ~_BV(digitalPinToPCMSKbit(morseInPin));
+  captureDecoder = 0;
+  SREG = oldSREG;
+#else
+#ifdef ARDUINO_NATIVE
+  nativePinChange(morseInPin, 0);
+#endif
+  captureDecoder = 0;
+#endif
+}
+
+
+
+void morseDecoder::captureEdge()
+{
+  morseDecoder *d = captureDecoder;
+  if (!d) return;
+
+#ifdef ARDUINO_NATIVE
+  queueEdge(d, nativePinLevel(d->morseInPin) ? HIGH : LOW);
+#else
+  queueEdge(d, d->keyerPin.read() ? HIGH : LOW);
+#endif
+}
+
+
+
+void morseDecoder::queueEdge(morseDecoder *d, boolean level)
+{
+  // Several pins share one vector, so only queue real changes of our pin
+  if (level == captureLevel) return;
+  captureLevel = level;
+
+  byte head = edgeHead;
+  byte next = (head + 1) & (MORSE_EDGE_BUFFER_SIZE - 1);
+  if (next == edgeTail)
+  {
+    d->edgeOverflows++;
+    return;
+  }
+  edgeTime[head] = micros();
+  edgeLevel[head] = level;
+  edgeHead = next;
+
+  byte queued = (next - edgeTail) & (MORSE_EDGE_BUFFER_SIZE - 1);
+  if (queued > d->edgeHighWater) d->edgeHighWater = queued;
+}
+
+
+
+boolean morseDecoder::readEdge(boolean *down, unsigned long *time)
+{
+  if (captureDecoder != this || edgeTail == edgeHead) return false;
+  byte tail = edgeTail;
+  *time = edgeTime[tail];
+  *down = activeLow ? !edgeLevel[tail] : edgeLevel[tail];
+  edgeTail = (tail + 1) & (MORSE_EDGE_BUFFER_SIZE - 1);
+  return true;
+}
+
+
+
+#if defined(__AVR__) && !defined(MORSE_NO_PCINT_ISR)
+#ifdef PCINT0_vect
+ISR(PCINT0_vect) { morseDecoder::captureEdge(); }
+#endif
+#ifdef PCINT1_vect
+ISR(PCINT1_vect) { morseDecoder::captureEdge(); }
+#endif
+#ifdef PCINT2_vect
+ISR(PCINT2_vect) { morseDecoder::captureEdge(); }
+#endif
+#ifdef PCINT3_vect
+ISR(PCINT3_vect) { morseDecoder::captureEdge(); }
+#endif
+#endif
+
+
+
+morseDecoder * volatile morseDecoder::toneDecoder = 0;
+volatile byte morseDecoder::sampleHead = 0;
+volatile byte morseDecoder::sampleTail = 0;
+volatile byte morseDecoder::sampleBuf[MORSE_SAMPLE_BUFFER_SIZE];
+
+boolean morseDecoder::beginTone(unsigned int toneHz)
+{
+  if (!morseAudio || toneHz == 0 || toneHz >= MORSE_SAMPLE_RATE / 2) return false;
+
+  endTone();
+  if (toneDecoder) toneDecoder->endTone();
+
+  toneCoeff = 2 * cos(2 * PI * toneHz / MORSE_SAMPLE_RATE) * 16384;
+  toneS1 = 0;
+  toneS2 = 0;
+  toneCount = 0;
+  toneState = false;
+  toneDc = 128 << 6;
+  noiseFloor = 0;
+  toneTime = micros();
+  sampleHead = 0;
+  sampleTail = 0;
+
+#ifdef __AVR__
+  byte channel = morseInPin;
+  if (channel >= A0) channel -= A0;
+
+  uint8_t oldSREG = SREG;
+  cli();
+  toneDecoder = this;
+  // AVcc reference, left adjusted so ADCH holds an 8 bit sample
+  ADMUX = _BV(REFS0) | _BV(ADLAR) | (channel & 0x07);
+  ADCSRB = 0;  // free running
+  ADCSRA = _BV(ADEN) | _BV(ADSC) | _BV(ADATE) | _BV(ADIE) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+  SREG = oldSREG;
+#else
+  // No ADC here, samples are fed through captureSample()
+  toneDecoder = this;
+#endif
+  return true;
+}
+
+
+
+void morseDecoder::endTone()
+{
+  if (toneDecoder != this) return;
+#ifdef __AVR__
+  uint8_t oldSREG = SREG;
+  cli();
+  // Back to single conversions, analogRead() sets ADMUX again itself
+  ADCSRA = _BV(ADEN) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+  toneDecoder = 0;
+  SREG = oldSREG;
+#else
+  toneDecoder = 0;
+#endif
+}
+
+
+
+void morseDecoder::captureSample(byte sample)
+{
+  morseDecoder *d = toneDecoder;
+  if (!d) return;
+
+  byte head = sampleHead;
+  byte next = (head + 1) & (MORSE_SAMPLE_BUFFER_SIZE - 1);
+  if (next == sampleTail)
+  {
+    d->sampleOverflows++;
+    return;
+  }
+  sampleBuf[head] = sample;
+  sampleHead = next;
+}
+
+
+
+#if defined(__AVR__) && !defined(MORSE_NO_ADC_ISR)
+ISR(ADC_vect) { morseDecoder::captureSample(ADCH); }
+#endif
+
+
+
+boolean morseDecoder::detectTone()
+{
+  // Goertzel filter over blocks of MORSE_TONE_BLOCK samples, returns true
+  // each time a block is complete and toneState holds its decision.
+  while (sampleTail != sampleHead)
+  {
+    byte tail = sampleTail;
+    int x = sampleBuf[tail] - (toneDc >> 6);
+    sampleTail = (tail + 1) & (MORSE_SAMPLE_BUFFER_SIZE - 1);
+    toneDc += x;
+
+    long s = x + ((toneCoeff * toneS1) >> 14) - toneS2;
+    toneS2 = toneS1;
+    toneS1 = s;
+    if (++toneCount < MORSE_TONE_BLOCK) continue;
+
+    // Power at the tone frequency, scaled down to stay within 32 bits
+    long a = toneS1 >> 2;
+    long b = toneS2 >> 2;
+    long power = a * a + b * b - ((toneCoeff * a) >> 14) * b;
+    toneS1 = 0;
+    toneS2 = 0;
+    toneCount = 0;
+
+    // The first block sets the noise floor
+    if (noiseFloor == 0) noiseFloor = power;
+
+    // Tone on 12 dB above the noise floor, off again below 6 dB
+    if (toneState)
+    {
+      if ((power >> 2) < noiseFloor) toneState = false;
+    } else {
+      if ((power >> 4) > noiseFloor) toneState = true;
+    }
+    if (!toneState)
+    {
+      // Blocks that look like noise move the floor quickly, anything louder
+      // (a tone still too weak to switch on) only very slowly
+      noiseFloor += (power - noiseFloor) >> ((power >> 2) < noiseFloor ? 5 : 9);
+      if (noiseFloor < MORSE_TONE_MIN_POWER) noiseFloor = MORSE_TONE_MIN_POWER;
+    }
+
+    toneTime += MORSE_TONE_BLOCK * 1000000UL / MORSE_SAMPLE_RATE;
+    return true;
+  }
+  return false;
 }
 
 
 
 void morseDecoder::setspeed(int value)
 {
-  wpm = value;
-  if (wpm <= 0) wpm = 1;
-  dotTime = 1200 / wpm;
-  dashTime = 3 * 1200 / wpm;
-  wordSpace = 7 * 1200 / wpm;
+  engine.setspeed(value);
+}
+
+
+
+int morseDecoder::getspeed()
+{
+  return engine.getspeed();
 }
 
 
 
 boolean morseDecoder::available()
 {
-  if (decodedMorseChar) return true; else return false;
+  return engine.available();
 }
 
 
 
 char morseDecoder::read()
 {
-  char temp = decodedMorseChar;
-  decodedMorseChar = '\0';
-  return temp;
+  return engine.read();
+}
+
+
+
+char morseDecoder::read(long *decodeTime)
+{
+  return engine.read(decodeTime);
 }
 
 
@@ -135,7 +404,7 @@ char morseDecoder::read()
 
 morseEncoder::morseEncoder(int encodePin)
 {
-  morseOutPin = encodePin;
+  morseOutPin.attach(encodePin);
 
   // some initial values
   sendingMorse = false;
@@ -179,188 +448,170 @@ void morseEncoder::write(char temp)
 
 void morseDecoder::decode()
 {
-  currentTime = millis();
-  
+  decodeLevel(polling() && keyerPin.read());
+}
+
+
+
+void morseDecoder::decodeLevel(boolean level)
+{
   // Read Morse signals
   if (morseAudio == false)
   {
-    // Read the Morse keyer (digital)
-    morseKeyer = digitalRead(morseInPin);
-    if (activeLow) morseKeyer = !morseKeyer;
-
-    // If the switch changed, due to noise or pressing:
-    if (morseKeyer != lastKeyerState) lastDebounceTime = currentTime; // reset timer
-  
-    // debounce the morse keyer
-    if ((currentTime - lastDebounceTime) > debounceDelay)
+    if (captureDecoder == this)
     {
-      // whatever the reading is at, it's been there for longer
-      // than the debounce delay, so take it as the actual current state:
-      morseSignalState = morseKeyer;
-      
-      // differentiante mark and space times
-      if (morseSignalState) markTime = lastDebounceTime; 
-      else spaceTime = lastDebounceTime;
+      // Replay the edges queued by the pin change interrupt in order, so no
+      // mark or space is lost however long the caller was busy elsewhere.
+      while (edgeTail != edgeHead)
+      {
+        byte tail = edgeTail;
+
+        // First decode the timeline up to this edge
+        currentTime = edgeTime[tail];
+        debounceKeyer();
+        engine.update(currentTime);
+        // Leave the rest queued until characters have been read
+        if (engine.outputFull()) return;
+
+        morseKeyer = edgeLevel[tail];
+        if (activeLow) morseKeyer = !morseKeyer;
+        edgeTail = (tail + 1) & (MORSE_EDGE_BUFFER_SIZE - 1);
+      }
+      currentTime = micros();
+    } else {
+      currentTime = micros();
+      debounceKeyer();  // the last reading held until now
+
+      // The Morse keyer (digital), read by the caller
+      morseKeyer = level;
+      if (activeLow) morseKeyer = !morseKeyer;
     }
+
+    debounceKeyer();
   } else {
-    // Read Morse audio signal
-    audioSignal = analogRead(morseInPin);
-    if (audioSignal > AudioThreshold)
+    if (toneDecoder == this)
     {
-      // If this is a new morse signal, reset morse signal timer
-      if (currentTime - lastDebounceTime > dotTime/2)
+      // One decision per tone detector block, timed by the sample clock
+      while (!engine.outputFull() && detectTone())
       {
-        markTime = currentTime;
-        morseSignalState = true; // there is currently a Morse signal
+        currentTime = toneTime;
+        trackAudio(toneState);
+        engine.update(currentTime);
       }
-      lastDebounceTime = currentTime;
     } else {
-      // if this is a new pause, reset space time
-      if (currentTime - lastDebounceTime > dotTime/2 && morseSignalState == true)
-      {
-        spaceTime = lastDebounceTime; // not too far off from last received audio
-        morseSignalState = false;     // No more signal
-      }
+      currentTime = micros();
+
+      // Read Morse audio signal
+      audioSignal = analogRead(morseInPin);
+      trackAudio(audioSignal > AudioThreshold);
     }
   }
-  
 
+  engine.update(currentTime);
+}
 
-  // Decode morse code
-  if (!morseSignalState)
+
+
+void morseDecoder::trackAudio(boolean tone)
+{
+  if (tone)
   {
-    if (!gotLastSig)
+    // If this is a new morse signal, reset morse signal timer
+    if (currentTime - lastDebounceTime > engine.dotLength()/2)
     {
-      if (morseTableJumper > 0)
-      {
-        // if pause for more than half a dot, get what kind of signal pulse (dot/dash) received last
-        if (currentTime - spaceTime > dotTime/2)
-        {
-          // if signal for more than 1/4 dotTime, take it as a morse pulse
-          if (spaceTime-markTime > dotTime/4)
-          {
-            // if signal for less than half a dash, take it as a dot
-            if (spaceTime-markTime < dashTime/2)
-            {
-               morseTablePointer -= morseTableJumper;
-               morseTableJumper /= 2;
-               gotLastSig = true;
-            }
-            // else if signal for between half a dash and a dash + one dot (1.33 dashes), take as a dash
-            else if (spaceTime-markTime < dashTime + dotTime)
-            {
-              morseTablePointer += morseTableJumper;
-              morseTableJumper /= 2;
-              gotLastSig = true;
-            }
-          }
-        }
-      } else { // error if too many pulses in one morse character
-        //Serial.println("<ERROR: unrecognized signal!>");
-        decodedMorseChar = '#'; // error mark
-        gotLastSig = true;
-        morseTableJumper = (morseTreetop+1)/2;
-        morseTablePointer = morseTreetop;
-      }
+      morseSignalState = true; // there is currently a Morse signal
+      engine.signal(true, currentTime);
     }
-    // Write out the character if pause is longer than 2/3 dash time (2 dots) and a character received
-    if ((currentTime-spaceTime >= (dotTime*2)) && (morseTableJumper < ((morseTreetop+1)/2)))
+    lastDebounceTime = currentTime;
+  } else {
+    // if this is a new pause, reset space time
+    if (currentTime - lastDebounceTime > engine.dotLength()/2 && morseSignalState == true)
     {
-      decodedMorseChar = morseTable[morseTablePointer];
-      morseTableJumper = (morseTreetop+1)/2;
-      morseTablePointer = morseTreetop;
+      morseSignalState = false;     // No more signal
+      engine.signal(false, lastDebounceTime); // not too far off from last received audio
     }
-    // Write a space if pause is longer than 2/3rd wordspace
-    if (currentTime-spaceTime > (wordSpace*2/3) && morseSpace == false)
+  }
+}
+
+
+
+void morseDecoder::debounceKeyer()
+{
+  // Integrate the keyer level since the last call. The debounced state
+  // follows the keyer once it has been ahead for a whole window, so contact
+  // bounce cancels out rather than restarting a timer. The window is a
+  // quarter dot, which keeps it usable at 60+ WPM.
+  long window = engine.dotLength() / 4;
+  if (window > debounceDelay * 1000) window = debounceDelay * 1000;
+  if (keyerIntegral > window) keyerIntegral = window;
+
+  long now = currentTime;
+  long dt = now - (long)keyerTime;
+  if (dt <= 0) return;
+  keyerTime = now;
+
+  if (morseKeyer)
+  {
+    if (morseSignalState || dt < window - keyerIntegral)
     {
-      //Serial.print(" ");
-      decodedMorseChar = ' ';
-      morseSpace = true ; // space written-flag
+      keyerIntegral = (dt < window - keyerIntegral) ? keyerIntegral + dt : window;
+      return;
     }
-
+    // The window filled up at this time
+    currentTime = now - dt + (window - keyerIntegral);
+    keyerIntegral = window;
   } else {
-    // while there is a signal, reset some flags
-    gotLastSig = false;
-    morseSpace = false;
+    if (!morseSignalState || dt < keyerIntegral)
+    {
+      keyerIntegral = (dt < keyerIntegral) ? keyerIntegral - dt : 0;
+      return;
+    }
+    currentTime = now - dt + keyerIntegral;
+    keyerIntegral = 0;
   }
-  
-  // Save the morse keyer state for next round
-  lastKeyerState = morseKeyer;
+
+  // Hand the switch to the engine at the time it happened
+  morseSignalState = morseKeyer;
+  engine.signal(morseSignalState, currentTime);
+  currentTime = now;
 }
 
 
 
 
 
+void morseEncoder::encode()
+{
+  int8_t level = encodeLevel();
+  if (level >= 0) morseOutPin.write(level);
+}
 
 
-void morseEncoder::encode()
+
+int8_t morseEncoder::encodeLevel()
 {
+  int8_t level = -1;  // pin unchanged
   currentTime = millis();
 
   if (!sendingMorse && encodeMorseChar)
   {
-    // change to capital letter if not
-    if (encodeMorseChar > 'Z') encodeMorseChar -= 'z'-'Z';
-  
-    // Scan for the character to send in the Morse table
-    int i;
-    for (i=0; i<morseTableLength; i++) if (morseTable[i] == encodeMorseChar) break;
-    int morseTablePos = i+1;  // 1-based position
-  
-    // Reverse dichotomic / binary tree path tracing
-  
-    // Find out what level in the binary tree the character is
-    int test;
-    for (i=0; i<morseTreeLevels; i++)
-    {
-      test = (morseTablePos + (0x0001 << i)) % (0x0002 << i);
-      if (test == 0) break;
-    }
-    int startLevel = i;
-    morseSignals = morseTreeLevels - i; // = the number of dots and/or dashes
-    morseSignalPos = 0;
-  
-    // Travel the reverse path to the top of the morse table
-    if (morseSignals > 0)
+    // Look up the dots and dashes, lowercase is folded by the table
+    byte code = morseEncode(encodeMorseChar);
+    if (code != 1)
     {
-      // build the morse signal (backwards from last signal to first)
-      for (i = startLevel; i<morseTreeLevels; i++)
-      {
-        int add = (0x0001 << i);
-        test = (morseTablePos + add) / (0x0002 << i);
-        if (test & 0x0001 == 1)
-        {
-          morseTablePos += add;
-          // Add a dot to the temporary morse signal string
-          morseSignalString[morseSignals-1 - morseSignalPos++] = '.';
-        } else {
-          morseTablePos -= add;
-          // Add a dash to the temporary morse signal string
-          morseSignalString[morseSignals-1 - morseSignalPos++] = '-';
-        }
-      }
-    } else {  // unless it was on the top to begin with (A space character)
+      morseSignals = 0;
+      for (; code > 1; code >>= 1) morseSignalString[morseSignals++] = (code & 1) ? '-' : '.';
+    } else {  // A space character, or one without Morse code
       morseSignalString[0] = ' ';
-      morseSignalPos = 1;
       morseSignals = 1; // cheating a little; a wordspace for a "morse signal"
     }
-    morseSignalString[morseSignalPos] = '\0';
-  
-  /*
-    if (morseTablePos-1 != morseTreetop)
-    {
-      Serial.println();
-      Serial.print("..Hm..error? MorseTablePos = ");
-      Serial.println(morseTablePos); 
-    }
-  */
+    morseSignalString[morseSignals] = '\0';
   
     // start sending the the character
     sendingMorse = true;
     sendingMorseSignalNr = 0;
     sendMorseTimer = currentTime;
-    if (morseSignalString[0] != ' ') digitalWrite(morseOutPin, HIGH);
+    if (morseSignalString[0] != ' ') level = HIGH;
   }
 
 
@@ -372,7 +623,7 @@ void morseEncoder::encode()
       case '.': // Send a dot (actually, stop sending a signal after a "dot time")
         if (currentTime - sendMorseTimer >= dotTime)
         {
-          digitalWrite(morseOutPin, LOW);
+          level = LOW;
           sendMorseTimer = currentTime;
           morseSignalString[sendingMorseSignalNr] = 'x'; // Mark the signal as sent
         }
@@ -380,7 +631,7 @@ void morseEncoder::encode()
       case '-': // Send a dash (same here, stop sending after a dash worth of time)
         if (currentTime - sendMorseTimer >= dashTime)
         {
-          digitalWrite(morseOutPin, LOW);
+          level = LOW;
           sendMorseTimer = currentTime;
           morseSignalString[sendingMorseSignalNr] = 'x'; // Mark the signal as sent
         }
@@ -392,7 +643,7 @@ void morseEncoder::encode()
           if (currentTime - sendMorseTimer >= dotTime)
           {
             sendingMorseSignalNr++;
-            digitalWrite(morseOutPin, HIGH); // Start sending the next signal
+            level = HIGH; // Start sending the next signal
             sendMorseTimer = currentTime;       // reset the timer
           }
         } else {
@@ -415,6 +666,7 @@ void morseEncoder::encode()
       encodeMorseChar = '\0';
     }
   }
+  return level;
 }
 
 
@@ -7,43 +7,121 @@
 #include <Arduino.h>
 #endif
 
+#include "MorseEngine.h"
+#include <FastPin.h>
+
 #define MORSE_AUDIO true
 #define MORSE_KEYER false
 #define MORSE_ACTIVE_LOW true
 #define MORSE_ACTIVE_HIGH false
 
+// Number of keyer edges the pin change interrupt can queue between two
+// calls to decode(). Must be a power of two.
+#ifndef MORSE_EDGE_BUFFER_SIZE
+#define MORSE_EDGE_BUFFER_SIZE 32
+#endif
+
+// Define MORSE_NO_PCINT_ISR if another library (e.g. SoftwareSerial) already
+// owns the pin change vectors, and call morseDecoder::captureEdge() from there.
+// With the input on a fixed pin, captureEdge(FastPin<pin>()) reads it with a
+// single sbis.
+
+// Audio samples the ADC interrupt can queue between two calls to decode()
+// in tone detector mode (beginTone()). Must be a power of two.
+#ifndef MORSE_SAMPLE_BUFFER_SIZE
+#define MORSE_SAMPLE_BUFFER_SIZE 64
+#endif
+
+// Free running ADC with a clk/128 prescaler, 13 clocks per conversion
+#ifndef MORSE_SAMPLE_RATE
+#define MORSE_SAMPLE_RATE (F_CPU / 128 / 13)
+#endif
+
+// Samples per Goertzel block, about 5 ms and 200 Hz bandwidth at 9615 Hz
+#ifndef MORSE_TONE_BLOCK
+#define MORSE_TONE_BLOCK 48
+#endif
+
+// Lowest noise floor, keeps the detector quiet when the input is silent
+#ifndef MORSE_TONE_MIN_POWER
+#define MORSE_TONE_MIN_POWER 64
+#endif
+
+// Define MORSE_NO_ADC_ISR if the ADC interrupt is used elsewhere, and
+// call morseDecoder::captureSample() with the 8 bit sample from there.
+
 
 class morseDecoder
 {
   public:
     morseDecoder(int decodePin, boolean listenAudio, boolean morsePullup);
+    ~morseDecoder();
+    boolean beginCapture();  // timestamp keyer edges from the pin change interrupt
+    void endCapture();
+    static void captureEdge();  // pin change interrupt handler
+    template <uint8_t PIN> static void captureEdge(FastPin<PIN>)  // ... for a decoder on PIN
+    {
+      morseDecoder *d = captureDecoder;
+      if (d && d->morseInPin == PIN) queueEdge(d, FastPin<PIN>::read());
+    }
+    boolean readEdge(boolean *down, unsigned long *time);  // next captured edge, undecoded, instead of decode()
+    boolean beginTone(unsigned int toneHz);  // detect toneHz with the free running ADC (MORSE_AUDIO)
+    void endTone();
+    static void captureSample(byte sample);  // ADC interrupt handler, sample 0..255
     void decode();
+    template <uint8_t PIN> void decode(FastPin<PIN>) { decodeLevel(polling() && FastPin<PIN>::read()); }
     void setspeed(int value);
+    int getspeed();         // current speed, follows the sender when engine.adaptiveSpeed is set
     char read();
+    char read(long *decodeTime);  // also returns when the character was decoded, in us
     boolean available();
+    morseEngine engine;     // the decoding itself, fed by the keyer or tone detector below
     int AudioThreshold;
-    long debounceDelay;     // the debounce time. Keep well below dotTime!!
+    long debounceDelay;     // longest debounce window in ms, below that it is a quarter dot
     boolean morseSignalState;  
+    unsigned int edgeOverflows;   // keyer edges lost because the capture buffer was full
+    byte edgeHighWater;           // most edges ever waiting in the capture buffer
+    unsigned int sampleOverflows; // audio samples lost because the sample buffer was full
   private:
+    boolean polling() { return !morseAudio && captureDecoder != this; }  // decode() reads the keyer pin
+    void decodeLevel(boolean level);  // decode(), level is the keyer pin read when polling
+    static void queueEdge(morseDecoder *d, boolean level);
+    void debounceKeyer();
+    boolean detectTone();
+    void trackAudio(boolean tone);
     int morseInPin;         // The Morse input pin
+    MorsePin keyerPin;      // ... read directly, in keyer mode
     int audioSignal;
-    int morseTableJumper;
-    int morseTablePointer;
-    int wpm;                // Word-per-minute speed
-    long dotTime;           // morse dot time length in ms
-    long dashTime;
-    long wordSpace;
-    boolean morseSpace;     // Flag to prevent multiple received spaces
-    boolean gotLastSig;     // Flag that the last received morse signal is decoded as dot or dash
-    boolean morseKeyer;
-    boolean lastKeyerState;
+    boolean morseKeyer;     // raw keyer level, debounced into morseSignalState
+    long keyerIntegral;     // us the keyer has been ahead of morseSignalState, 0..window
+    unsigned long keyerTime;  // time keyerIntegral was last brought up to date
     boolean morseAudio;
     boolean activeLow;
-    long markTime;          // timers for mark and space in morse signal
-    long spaceTime;         // E=MC^2 ;p
     long lastDebounceTime;  // the last time the input pin was toggled
-    long currentTime;       // The current (signed) time
-    char decodedMorseChar;  // The last decoded Morse character
+    long currentTime;       // The current (signed) time in us
+
+    // Keyer edge capture, filled by captureEdge() and drained by decode().
+    // Only one decoder captures at a time, so it shares one static buffer
+    // instead of each decoder (usually a local) carrying its own.
+    static morseDecoder * volatile captureDecoder;  // read by the interrupt
+    static volatile boolean captureLevel;  // last raw pin level queued
+    static volatile byte edgeHead;      // written by the interrupt only
+    static volatile byte edgeTail;      // written by decode() only
+    static volatile unsigned long edgeTime[MORSE_EDGE_BUFFER_SIZE];
+    static volatile boolean edgeLevel[MORSE_EDGE_BUFFER_SIZE];
+
+    // Tone detector, samples queued by captureSample() and drained by decode()
+    static morseDecoder * volatile toneDecoder;  // read by the interrupt
+    static volatile byte sampleHead;    // written by the interrupt only
+    static volatile byte sampleTail;    // written by decode() only
+    static volatile byte sampleBuf[MORSE_SAMPLE_BUFFER_SIZE];
+    int toneCoeff;          // Goertzel coefficient 2*cos(w), Q14
+    long toneS1, toneS2;    // Goertzel state of the current block
+    byte toneCount;         // samples in the current block
+    boolean toneState;      // tone present in the last block
+    long noiseFloor;        // average block power without tone
+    int toneDc;             // average sample, Q6
+    unsigned long toneTime; // time at the end of the current block
 };
 
 
@@ -54,20 +132,25 @@ class morseEncoder
   public:
     morseEncoder(int encodePin);
     void encode();
+    template <uint8_t PIN> void encode(FastPin<PIN>)  // ... with the output on PIN
+    {
+      int8_t level = encodeLevel();
+      if (level >= 0) FastPin<PIN>::write(level);
+    }
     void setspeed(int value);
     void write(char temp);
     boolean available();
-    char morseSignalString[7];// Morse signal for one character as temporary ASCII string of dots and dashes
+    char morseSignalString[8];// Morse signal for one character as temporary ASCII string of dots and dashes
   private:
+    int8_t encodeLevel();   // encode(), the level to write the pin to or -1
     char encodeMorseChar;   // ASCII character to encode
-    int morseOutPin;
+    MorsePin morseOutPin;
     boolean sendingMorse;
     int wpm;                // Word-per-minute speed
     long dotTime;           // morse dot time length in ms
     long dashTime;
     long wordSpace;
     int morseSignals;       // nr of morse signals to send in one morse character
-    int morseSignalPos;
     int sendingMorseSignalNr;
     long sendMorseTimer;
     long lastDebounceTime;
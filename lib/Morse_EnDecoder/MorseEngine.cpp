@@ -0,0 +1,523 @@
+/*          MORSE ENGINE
+
+ - The decoding state machine of MorseEnDecoder, free of Arduino calls.
+   See MorseEngine.h. Times are in us.
+
+ Copyright (C) 2010-2012 raron
+
+ GNU GPLv3 license, see MorseEnDecoder.cpp
+*/
+
+
+#include "MorseEngine.h"
+#include <MorseCode.h>
+#ifndef __AVR__
+#include <math.h>
+#endif
+
+
+
+morseEngine::morseEngine()
+{
+  wpm = 13;
+  dotTime = 1200000L / wpm;   // morse dot time length in us
+  dashTime = 3 * 1200000L / wpm;
+  wordSpace = 7 * 1200000L / wpm;
+  adaptiveSpeed = true;
+  softDecision = false;
+  setThresholds(MORSE_MARK_MIN, MORSE_DASH_SPLIT, MORSE_CHAR_GAP, MORSE_WORD_GAP);
+
+  morseCode = 0;
+  morseElements = 0;
+  morseSignalState = false;
+  shortMarks = fastMarks = 0;
+
+  gotLastSig = true;
+  morseSpace = true;
+  outHead = 0;
+  outTail = 0;
+  droppedChars = 0;
+
+  markTime = 0;
+  spaceTime = 0;
+  currentTime = 0;
+
+#ifndef MORSE_NO_SOFT_DECISION
+  softMarkEnd = 0;
+#if !defined(__AVR__) && !defined(MORSE_SOFT_FIXED)
+  softSpread[0] = softSpread[1] = 0.35f * 0.35f;
+  softBias[0] = softBias[1] = 0;
+#endif
+#endif
+}
+
+
+
+void morseEngine::signal(bool on, long time)
+{
+  // First decode the timeline up to this change
+  update(time);
+  if (on == morseSignalState) return;
+
+  morseSignalState = on;
+  if (on)
+  {
+    // The last mark was never read, the gap after it was shorter than half
+    // a dot: the sender got a lot faster, so let the speed follow it anyway
+    if (adaptiveSpeed && !gotLastSig && spaceTime-markTime > dotTime/8) trackSpeed(spaceTime-markTime, true);
+    markTime = time;
+  }
+  else spaceTime = time;
+  decodeSignal();
+}
+
+
+
+void morseEngine::update(long time)
+{
+  currentTime = time;
+  decodeSignal();
+}
+
+
+
+void morseEngine::element(bool on, long duration)
+{
+  signal(on, currentTime);
+  update(currentTime + duration);
+}
+
+
+
+void morseEngine::setspeed(int value)
+{
+  wpm = value;
+  if (wpm <= 0) wpm = 1;
+  dotTime = 1200000L / wpm;
+  dashTime = 3 * 1200000L / wpm;
+  wordSpace = 7 * 1200000L / wpm;
+  shortMarks = fastMarks = 0;
+  scaleThresholds();
+}
+
+
+
+void morseEngine::setThresholds(uint16_t markMin, uint16_t dashSplit, uint16_t charGap, uint16_t wordGap)
+{
+  // Marks longer than markMin/256 dot count, marks shorter than
+  // dashSplit/256 dash are dots, a pause of charGap/256 dot ends the
+  // character and one of wordGap/256 word space the word.
+  this->markMin = markMin;
+  this->dashSplit = dashSplit;
+  this->charGap = charGap;
+  this->wordGap = wordGap;
+  scaleThresholds();
+}
+
+
+
+void morseEngine::scaleThresholds()
+{
+  // Once per speed change, so decodeSignal() only compares
+  markMinTime = (dotTime * markMin) >> 8;
+  dashSplitTime = (dashTime * dashSplit) >> 8;
+  charGapTime = (dotTime * charGap) >> 8;
+  wordGapTime = (wordSpace * wordGap) >> 8;
+}
+
+
+
+int morseEngine::getspeed()
+{
+  return wpm;
+}
+
+
+
+long morseEngine::dotLength()
+{
+  return dotTime;
+}
+
+
+
+bool morseEngine::signalOn()
+{
+  return morseSignalState;
+}
+
+
+
+void morseEngine::trackSpeed(long duration, bool mark)
+{
+  // Dots and dashes are two clusters, split halfway between them. An element
+  // moves its own cluster a quarter of the way and pulls the other one along
+  // at the 1:3 ratio, so a speed change is picked up within a character or
+  // two. Gaps inside a character count as a dot at half the weight.
+  long split = (dotTime + dashTime) / 2;
+  if (duration > 2 * dashTime) duration = 2 * dashTime;  // a held key, not a dash
+  if (mark)
+  {
+    if (duration >= dotTime) shortMarks = fastMarks = 0;
+    else if (!shortMarks++) shortestMark = longestMark = duration;
+    else if (duration < shortestMark) shortestMark = duration;
+    else if (duration > longestMark) longestMark = duration;
+    if (duration < dotTime / 2) fastMarks++;
+  }
+  if (fastMarks >= 2 && shortMarks >= 3 && 2 * longestMark > 5 * shortestMark)
+  {
+    // Dots and dashes in a row all shorter than a dot are a big speed-up:
+    // the dashes would land among the dots and hold the clusters back, so
+    // start again from the shortest mark. Jittered dots alone are not this.
+    dotTime = shortestMark;
+    dashTime = 3 * shortestMark;
+    shortMarks = fastMarks = 0;
+  } else if (duration < split) {
+    uint8_t shift = mark ? 2 : 3;
+    if (duration < dotTime / 2) shift = 1;  // much faster than we thought
+    dotTime += (duration - dotTime) >> shift;
+    dashTime += (3 * dotTime - dashTime) >> (shift + 1);
+  } else {
+    if (!mark) return;
+    dashTime += (duration - dashTime) >> 2;
+    dotTime += (dashTime / 3 - dotTime) >> 3;
+  }
+
+  if (dotTime < 1200000L / MORSE_MAX_WPM) dotTime = 1200000L / MORSE_MAX_WPM;
+  if (dotTime > 1200000L / MORSE_MIN_WPM) dotTime = 1200000L / MORSE_MIN_WPM;
+  if (dashTime < 2 * dotTime) dashTime = 2 * dotTime;
+
+  long unit = (dotTime + dashTime / 3) / 2;
+  wordSpace = 7 * unit;
+  wpm = 1200000L / unit;
+  scaleThresholds();
+}
+
+
+
+bool morseEngine::available()
+{
+  if (outHead != outTail) return true; else return false;
+}
+
+
+
+char morseEngine::read()
+{
+  return read(0);
+}
+
+
+
+char morseEngine::read(long *decodeTime)
+{
+  if (outHead == outTail) return '\0';
+  char temp = outChar[outTail];
+  if (decodeTime) *decodeTime = outTime[outTail];
+  outTail = (outTail + 1) & (MORSE_OUTPUT_BUFFER_SIZE - 1);
+  return temp;
+}
+
+
+
+void morseEngine::output(char c)
+{
+  uint8_t next = (outHead + 1) & (MORSE_OUTPUT_BUFFER_SIZE - 1);
+  if (next == outTail)
+  {
+    droppedChars++;
+    return;
+  }
+  outChar[outHead] = c;
+  outTime[outHead] = currentTime;
+  outHead = next;
+}
+
+
+
+bool morseEngine::outputFull()
+{
+  // One decodeSignal() call can write a character and a word space
+  return ((outTail - outHead - 1) & (MORSE_OUTPUT_BUFFER_SIZE - 1)) < 2;
+}
+
+
+
+#ifndef MORSE_NO_SOFT_DECISION
+#if defined(__AVR__) || defined(MORSE_SOFT_FIXED)
+
+// Cost of an element that is i/16 of its expected length, 16*log2(i/16)^2/(2*0.35^2)
+static const uint8_t softCostTable[64] PROGMEM = {
+  255, 255, 255, 255, 255, 184, 131,  93,  65,  45,  30,  19,  11,   6,   2,   1,
+    0,   0,   2,   4,   7,  10,  14,  18,  22,  27,  32,  37,  43,  48,  54,  59,
+   65,  71,  77,  83,  89,  96, 102, 108, 114, 120, 127, 133, 139, 145, 152, 158,
+  164, 170, 176, 183, 189, 195, 201, 207, 213, 219, 225, 231, 237, 243, 249, 255,
+};
+
+static morseRatio softRatio(long length, long expected)
+{
+  if (length >= 4 * expected) return 63;
+  if (length <= 0) return 0;
+  return (length << 4) / expected;
+}
+
+
+
+uint16_t morseEngine::softCost(morseRatio r, bool mark)
+{
+  (void)mark;
+  return pgm_read_byte(&softCostTable[r]);
+}
+
+#else
+
+static morseRatio softRatio(long length, long expected)
+{
+  if (length <= 0) return -8;
+  return log2f((float)length / expected);
+}
+
+
+
+void morseEngine::softLearn(uint8_t m, float r)
+{
+  // Marks [0] and gaps [1] are both log2 lengths, off by a bias and spread
+  r -= softBias[m];
+  softBias[m] += r / 16;
+  softSpread[m] += (r * r - softSpread[m]) / 32;
+  if (softBias[m] < -0.5f) softBias[m] = -0.5f;
+  if (softBias[m] > 0.5f) softBias[m] = 0.5f;
+  if (softSpread[m] < 0.02f) softSpread[m] = 0.02f;
+  if (softSpread[m] > 0.36f) softSpread[m] = 0.36f;
+}
+
+
+
+uint16_t morseEngine::softCost(morseRatio r, bool mark)
+{
+  // Log-normal, around the lengths this sender keys marks and gaps with
+  // (weight shifts them) and with the spread they come with
+  uint8_t m = mark ? 0 : 1;
+  r -= softBias[m];
+  float cost = 8 * r * r / softSpread[m];
+  return cost > 1023 ? 1023 : (uint16_t)(cost + 0.5f);
+}
+
+#endif
+
+
+
+void morseEngine::softElement()
+{
+  // A full buffer writes out all but its last character, which may go on
+  if (morseElements >= MORSE_SOFT_ELEMENTS) softDecode(false);
+
+  uint8_t n = morseElements;
+  long mark = spaceTime - markTime;
+  softMark[n][0] = softRatio(mark, dotTime);
+  softMark[n][1] = softRatio(mark, dashTime);
+  if (n > 0)
+  {
+    long gap = markTime - softMarkEnd;
+    softGap[n][0] = softRatio(gap, dotTime);
+    softGap[n][1] = softRatio(gap, dashTime);
+  }
+  softMarkEnd = spaceTime;
+  morseElements++;
+}
+
+
+
+uint16_t morseEngine::softChar(uint8_t first, uint8_t count, uint8_t *code)
+{
+  // Cheapest code of a character for count marks from first. Deciding each
+  // mark on its own is cheapest; only when that spells no character are
+  // all 2^count codes tried, at most 128 for seven marks.
+  uint16_t cost[7][2];
+  uint16_t total = 0;
+  uint8_t end = 1 << count;
+  uint8_t hard = 0;
+  for (uint8_t k = 0; k < count; k++)
+  {
+    cost[k][0] = softCost(softMark[first + k][0], true);
+    cost[k][1] = softCost(softMark[first + k][1], true);
+    if (cost[k][1] < cost[k][0])
+    {
+      hard |= 1 << k;
+      total += cost[k][1];
+    } else {
+      total += cost[k][0];
+    }
+  }
+  *code = hard | end;
+  if (morseDecode(hard | end) != '*') return total;
+
+  uint16_t best = 0xFFFF;
+  for (uint8_t bits = 0; bits < end; bits++)
+  {
+    if (morseDecode(bits | end) == '*') continue;
+    total = 0;
+    for (uint8_t k = 0; k < count; k++) total += cost[k][(bits >> k) & 1];
+    if (total < best)
+    {
+      best = total;
+      *code = bits | end;
+    }
+  }
+  return best;
+}
+
+
+
+void morseEngine::softDecode(bool all)
+{
+  // Viterbi over where the characters end. best[j] is the cheapest reading
+  // of the first j marks: a character of the marks since from[j], after a
+  // character gap, and best[from[j]] before it. Bounded by
+  // MORSE_SOFT_ELEMENTS * 7 softChar() calls.
+  uint8_t n = morseElements;
+  uint16_t best[MORSE_SOFT_ELEMENTS + 1];
+  uint8_t from[MORSE_SOFT_ELEMENTS + 1];
+  uint8_t code[MORSE_SOFT_ELEMENTS + 1];
+  best[0] = 0;
+  for (uint8_t j = 1; j <= n; j++)
+  {
+    best[j] = 0xFFFF;
+    for (uint8_t len = 1; len <= 7 && len <= j; len++)
+    {
+      uint8_t i = j - len;
+      uint8_t c;
+      uint16_t cost = softChar(i, len, &c);
+      if (cost == 0xFFFF) continue;
+      cost += best[i];
+      if (i > 0) cost += softCost(softGap[i][1], false);
+      for (uint8_t k = i + 1; k < j; k++) cost += softCost(softGap[k][0], false);
+      if (cost < best[j])
+      {
+        best[j] = cost;
+        from[j] = i;
+        code[j] = c;
+      }
+    }
+  }
+
+  // Walk back to the start, then write the characters out in order
+  uint8_t ends[MORSE_SOFT_ELEMENTS];
+  uint8_t chars = 0;
+  for (uint8_t j = n; j > 0; j = from[j]) ends[chars++] = j;
+  uint8_t keep = (all || chars < 2) ? 0 : 1;
+  while (chars > keep)
+  {
+    uint8_t j = ends[--chars];
+    output(morseDecode(code[j]));
+#if !defined(__AVR__) && !defined(MORSE_SOFT_FIXED)
+    // Learn how this sender strays from the lengths just read
+    for (uint8_t k = from[j]; k < j; k++)
+    {
+      softLearn(0, softMark[k][(code[j] >> (k - from[j])) & 1]);
+      if (k > 0) softLearn(1, softGap[k][k == from[j] ? 1 : 0]);
+    }
+#endif
+  }
+
+  // Move the marks of a character kept back to the front
+  uint8_t first = keep ? from[n] : n;
+  for (uint8_t k = first; k < n; k++)
+  {
+    softMark[k - first][0] = softMark[k][0];
+    softMark[k - first][1] = softMark[k][1];
+    softGap[k - first][0] = softGap[k][0];
+    softGap[k - first][1] = softGap[k][1];
+  }
+  morseCode = 0;
+  morseElements = n - first;
+}
+
+#endif
+
+
+
+void morseEngine::decodeSignal()
+{
+  // Decode morse code
+  if (!morseSignalState)
+  {
+    if (!gotLastSig)
+    {
+      // if pause for more than half a dot, get what kind of signal pulse (dot/dash) received last.
+      // Soft decision takes every mark as it ends, a mark is not lost to a short gap after it.
+      if (currentTime - spaceTime > dotTime/2 || softDecision)
+      {
+        // if signal for more than markMin (1/4 dotTime), take it as a morse pulse
+        if (spaceTime-markTime > markMinTime)
+        {
+#ifndef MORSE_NO_SOFT_DECISION
+          // soft decision: keep the lengths, the characters are picked later
+          if (softDecision)
+          {
+            softElement();
+            gotLastSig = true;
+          }
+          else
+#endif
+          // error if too many pulses in one morse character
+          if (morseElements >= 7)
+          {
+            //Serial.println("<ERROR: unrecognized signal!>");
+            output('#'); // error mark
+            gotLastSig = true;
+            morseCode = 0;
+            morseElements = 0;
+          }
+          // if signal for less than dashSplit (half a dash), take it as a dot
+          else if (spaceTime-markTime < dashSplitTime)
+          {
+             morseElements++;
+             gotLastSig = true;
+          }
+          // else if signal for between dashSplit and a dash + one dot (1.33 dashes), take as a dash
+          else if (spaceTime-markTime < dashTime + dotTime)
+          {
+            morseCode |= 1 << morseElements;
+            morseElements++;
+            gotLastSig = true;
+          }
+        }
+        // Learn from every mark, also the ones too long or too short to
+        // decode at the current speed, so a big speed change is picked up
+        if (adaptiveSpeed && spaceTime-markTime > dotTime/8)
+        {
+          trackSpeed(spaceTime-markTime, true);
+          gotLastSig = true;
+        }
+      }
+    }
+    // Write out the character if pause is longer than charGap (2 dots) and a character received.
+    // Soft decision waits half a dot longer and lets softDecode() split the marks up.
+    if ((currentTime-spaceTime >= charGapTime + (softDecision ? dotTime/2 : 0)) && morseElements > 0)
+    {
+#ifndef MORSE_NO_SOFT_DECISION
+      if (softDecision) softDecode(true);
+      else
+#endif
+      output(morseDecode(morseCode | (1 << morseElements)));
+      morseCode = 0;
+      morseElements = 0;
+    }
+    // Write a space if pause is longer than wordGap (2/3rd wordspace)
+    if (currentTime-spaceTime > wordGapTime && morseSpace == false)
+    {
+      //Serial.print(" ");
+      output(' ');
+      morseSpace = true ; // space written-flag
+    }
+
+  } else {
+    // A new mark inside a character, the gap before it was one element space
+    if (adaptiveSpeed && gotLastSig && morseElements > 0) trackSpeed(markTime-spaceTime, false);
+
+    // while there is a signal, reset some flags
+    gotLastSig = false;
+    morseSpace = false;
+  }
+}
@@ -0,0 +1,140 @@
+#ifndef MorseEngine_H
+#define MorseEngine_H
+
+// The decoding state machine of morseDecoder, without any pin, clock or
+// Arduino dependency. Feed it mark/space changes with their time in us,
+// from a pin, an audio detector, a recording or a test, and read the
+// characters back:
+//
+//   morseEngine e;
+//   e.signal(true, 0);         // key down at 0 us
+//   e.signal(false, 60000);    // up again, a dot at 20 WPM
+//   e.update(500000);          // nothing else happened until 0.5 s
+//   while (e.available()) putchar(e.read());
+
+#include <stdint.h>
+
+// Decoded characters (and word spaces) held for read(). Must be a power of two.
+#ifndef MORSE_OUTPUT_BUFFER_SIZE
+#define MORSE_OUTPUT_BUFFER_SIZE 8
+#endif
+
+// Speed range the adaptive speed tracking stays within
+#ifndef MORSE_MIN_WPM
+#define MORSE_MIN_WPM 5
+#endif
+#ifndef MORSE_MAX_WPM
+#define MORSE_MAX_WPM 100
+#endif
+
+// Default decision thresholds, in 1/256 of the length they scale with,
+// see setThresholds(). tools/morsesweep.cpp measures other choices.
+#ifndef MORSE_MARK_MIN
+#define MORSE_MARK_MIN 64       // shortest mark, 1/4 dot
+#endif
+#ifndef MORSE_DASH_SPLIT
+#define MORSE_DASH_SPLIT 128    // dot/dash split, 1/2 dash
+#endif
+#ifndef MORSE_CHAR_GAP
+#define MORSE_CHAR_GAP 512      // character end, 2 dots
+#endif
+#ifndef MORSE_WORD_GAP
+#define MORSE_WORD_GAP 171      // word end, 2/3 word space
+#endif
+
+// Marks the soft decision mode keeps for one decision, so characters keyed
+// into each other without a character gap can still be split apart
+#ifndef MORSE_SOFT_ELEMENTS
+#define MORSE_SOFT_ELEMENTS 8
+#endif
+
+// Define MORSE_NO_SOFT_DECISION to leave the soft decision mode out and
+// save its RAM. On AVR, or with MORSE_SOFT_FIXED, it uses a fixed table of
+// costs; on the host a log-normal model that learns the sender's weight
+// and spread.
+#ifndef MORSE_NO_SOFT_DECISION
+#if defined(__AVR__) || defined(MORSE_SOFT_FIXED)
+typedef uint8_t morseRatio;   // element length / expected length, Q4
+#else
+typedef float morseRatio;     // log2(element length / expected length)
+#endif
+#endif
+
+class morseEngine
+{
+  public:
+    morseEngine();
+    void signal(bool on, long time);      // the signal went on (mark) or off (space) at time
+    void update(long time);               // the signal stayed as it is until time
+    void element(bool on, long duration); // a mark or space of duration, following the last one
+    void setspeed(int value);
+    void setThresholds(uint16_t markMin, uint16_t dashSplit, uint16_t charGap, uint16_t wordGap);
+    int getspeed();         // current speed, follows the sender when adaptiveSpeed is set
+    long dotLength();       // current dot time in us
+    bool signalOn();
+    char read();
+    char read(long *decodeTime);  // also returns when the character was decoded, in us
+    bool available();
+    bool outputFull();      // fewer than two free places for decoded characters
+    bool adaptiveSpeed;     // track the sender's speed from the received elements (default on)
+    bool softDecision;      // pick the likeliest characters instead of deciding every element (default off)
+    unsigned int droppedChars;    // decoded characters lost because nobody read them in time
+  private:
+    void decodeSignal();
+    void trackSpeed(long duration, bool mark);
+    void output(char c);
+    void scaleThresholds();
+#ifndef MORSE_NO_SOFT_DECISION
+    void softElement();
+    void softDecode(bool all);
+    uint16_t softCost(morseRatio r, bool mark);
+    uint16_t softChar(uint8_t first, uint8_t count, uint8_t *code);
+#if !defined(__AVR__) && !defined(MORSE_SOFT_FIXED)
+    void softLearn(uint8_t m, float r);
+#endif
+#endif
+    uint8_t morseCode;      // dots and dashes received so far, packed as in MorseCode.h
+    uint8_t morseElements;  // number of them
+    int wpm;                // Word-per-minute speed
+    long dotTime;           // morse dot time length in us
+    long dashTime;
+    long wordSpace;
+    long shortestMark;      // of the marks in a row shorter than a dot
+    long longestMark;
+    uint8_t shortMarks;
+    uint8_t fastMarks;      // of those, shorter than half a dot
+    uint16_t markMin;       // thresholds in 1/256, as given to setThresholds()
+    uint16_t dashSplit;
+    uint16_t charGap;
+    uint16_t wordGap;
+    long markMinTime;       // ... and in us at the current speed
+    long dashSplitTime;
+    long charGapTime;
+    long wordGapTime;
+    bool morseSignalState;
+    bool morseSpace;        // Flag to prevent multiple received spaces
+    bool gotLastSig;        // Flag that the last received morse signal is decoded as dot or dash
+    long markTime;          // timers for mark and space in morse signal
+    long spaceTime;
+    long currentTime;       // The current (signed) time in us
+
+#ifndef MORSE_NO_SOFT_DECISION
+    // Soft decision: each mark measured as a dot [0] and as a dash [1], each
+    // gap before a mark as an element gap [0] and as a character gap [1]
+    morseRatio softMark[MORSE_SOFT_ELEMENTS][2];
+    morseRatio softGap[MORSE_SOFT_ELEMENTS][2];
+    long softMarkEnd;       // end of the last mark taken
+#if !defined(__AVR__) && !defined(MORSE_SOFT_FIXED)
+    float softBias[2];      // mean of log2 mark and gap lengths, off the expected
+    float softSpread[2];    // ... and their variance
+#endif
+#endif
+
+    // Decoded characters waiting for read(), oldest at outTail
+    uint8_t outHead;
+    uint8_t outTail;
+    char outChar[MORSE_OUTPUT_BUFFER_SIZE];
+    long outTime[MORSE_OUTPUT_BUFFER_SIZE];
+};
+
+#endif
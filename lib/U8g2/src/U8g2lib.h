@@ -152,6 +152,9 @@ class U8G2 : public Print
     /* u8g2_buffer.c */
     void sendBuffer(void) { u8g2_SendBuffer(&u8g2); }
     void clearBuffer(void) { u8g2_ClearBuffer(&u8g2); }    
+    void sendDirtyBuffer(void) { u8g2_SendDirtyBuffer(&u8g2); }
+    uint8_t sendBufferStep(void) { return u8g2_SendBufferStep(&u8g2); }
+    void setBufferDirty(uint8_t is_dirty) { u8g2_SetBufferDirty(&u8g2, is_dirty); }
     
     void firstPage(void) { u8g2_FirstPage(&u8g2); }
     uint8_t nextPage(void) { return u8g2_NextPage(&u8g2); }
@@ -212,6 +215,12 @@ class U8G2 : public Print
 
     void setFont(const uint8_t  *font) {u8g2_SetFont(&u8g2, font); }
     void setFontMode(uint8_t  is_transparent) {u8g2_SetFontMode(&u8g2, is_transparent); }
+#ifdef U8G2_WITH_GLYPH_CACHE
+    void setGlyphCache(uint8_t *buf, uint16_t size, const uint8_t *font) { u8g2_SetGlyphCache(&u8g2, buf, size, font); }
+#endif
+#ifdef U8G2_WITH_FONT_INDEX
+    void setFontIndex(const uint8_t *font) { u8g2_SetFontIndex(&u8g2, font); }
+#endif
     void setFontDirection(uint8_t dir) {u8g2_SetFontDirection(&u8g2, dir); }
 
     int8_t getAscent(void) { return u8g2_GetAscent(&u8g2); }
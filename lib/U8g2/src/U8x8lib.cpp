@@ -42,8 +42,12 @@
 #include <SPI.h>
 #endif 
 #ifdef U8X8_HAVE_HW_I2C
+#ifdef U8X8_HAVE_AVR_TWI
+#include <util/twi.h>
+#else
 #include <Wire.h>
 #endif
+#endif
 
 /*=============================================*/
 
@@ -68,6 +72,57 @@ size_t U8X8::write(uint8_t v)
 /* callbacks */
 
 #ifdef U8X8_USE_PINS
+
+#if defined(__AVR__) && !defined(U8X8_NO_AVR_FAST_GPIO)
+/*
+  Software I2C lines on AVR: pinMode() plus digitalWrite() for every edge
+  cost well over 100 cycles, so the ports and masks of the two lines are
+  looked up once and the lines are switched with direct register writes.
+  The cache follows the pins, so several displays can share it.
+*/
+#define U8X8_AVR_FAST_GPIO
+
+static uint8_t arduino_i2c_pin[2] = { U8X8_PIN_NONE, U8X8_PIN_NONE };
+static volatile uint8_t *arduino_i2c_port[2];
+static volatile uint8_t *arduino_i2c_ddr[2];
+static uint8_t arduino_i2c_mask[2];
+
+static void u8x8_arduino_i2c_line(uint8_t pin, uint8_t idx, uint8_t arg_int)
+{
+  volatile uint8_t *port;
+  volatile uint8_t *ddr;
+  uint8_t mask;
+  uint8_t sreg;
+
+  if ( arduino_i2c_pin[idx] != pin )
+  {
+    arduino_i2c_pin[idx] = pin;
+    arduino_i2c_port[idx] = portOutputRegister(digitalPinToPort(pin));
+    arduino_i2c_ddr[idx] = portModeRegister(digitalPinToPort(pin));
+    arduino_i2c_mask[idx] = digitalPinToBitMask(pin);
+  }
+  port = arduino_i2c_port[idx];
+  ddr = arduino_i2c_ddr[idx];
+  mask = arduino_i2c_mask[idx];
+
+  sreg = SREG;
+  cli();
+  if ( arg_int == 0 )
+  {
+    /* pull-up off first, then drive low: the line never gets driven high */
+    *port &= ~mask;
+    *ddr |= mask;
+  }
+  else
+  {
+    /* release the line, then the internal pull-up, like INPUT_PULLUP */
+    *ddr &= ~mask;
+    *port |= mask;
+  }
+  SREG = sreg;
+}
+#endif
+
 extern "C" uint8_t u8x8_gpio_and_delay_arduino(u8x8_t *u8x8, uint8_t msg, uint8_t arg_int, U8X8_UNUSED void *arg_ptr)
 {
   uint8_t i;
@@ -120,6 +175,14 @@ extern "C" uint8_t u8x8_gpio_and_delay_arduino(u8x8_t *u8x8, uint8_t msg, uint8_
       break;
     case U8X8_MSG_GPIO_I2C_CLOCK:
     case U8X8_MSG_GPIO_I2C_DATA:
+#ifdef U8X8_AVR_FAST_GPIO
+      i = u8x8_GetPinValue(u8x8, msg);
+      if ( i != U8X8_PIN_NONE && digitalPinToPort(i) != NOT_A_PIN )
+      {
+	u8x8_arduino_i2c_line(i, msg == U8X8_MSG_GPIO_I2C_DATA, arg_int);
+	break;
+      }
+#endif
       if ( arg_int == 0 )
       {
 	pinMode(u8x8_GetPinValue(u8x8, msg), OUTPUT);
@@ -553,9 +616,36 @@ extern "C" uint8_t u8x8_byte_arduino_2nd_hw_spi(U8X8_UNUSED u8x8_t *u8x8, U8X8_U
 
 /*=============================================*/
 
+#ifdef U8X8_HAVE_AVR_TWI
+#include "U8x8lib_avr_twi.h"
+#endif
+
 extern "C" uint8_t u8x8_byte_arduino_hw_i2c(U8X8_UNUSED u8x8_t *u8x8, U8X8_UNUSED uint8_t msg, U8X8_UNUSED uint8_t arg_int, U8X8_UNUSED void *arg_ptr)
 {
-#ifdef U8X8_HAVE_HW_I2C
+#if defined(U8X8_HAVE_AVR_TWI)
+  switch(msg)
+  {
+    case U8X8_MSG_BYTE_SEND:
+      u8x8_avr_twi_add(arg_int, (const uint8_t *)arg_ptr);
+      break;
+    case U8X8_MSG_BYTE_INIT:
+      u8x8_avr_twi_init(u8x8);
+      /* without the Wire limit, the ssd13xx data can be sent in one transfer */
+      if ( u8x8->cad_cb == u8x8_cad_ssd13xx_i2c )
+	u8x8->cad_cb = u8x8_cad_ssd13xx_fast_i2c;
+      break;
+    case U8X8_MSG_BYTE_SET_DC:
+      break;
+    case U8X8_MSG_BYTE_START_TRANSFER:
+      u8x8_avr_twi_start(u8x8);
+      break;
+    case U8X8_MSG_BYTE_END_TRANSFER:
+      u8x8_avr_twi_stop();
+      break;
+    default:
+      return 0;
+  }
+#elif defined(U8X8_HAVE_HW_I2C)
   switch(msg)
   {
     case U8X8_MSG_BYTE_SEND:
@@ -75,6 +75,14 @@
 #endif 
 #endif
 
+/* On AVR boards with a TWI unit, u8x8_byte_arduino_hw_i2c drives the TWI */
+/* registers from the TWI interrupt instead of using Wire. */
+/* Define U8X8_NO_AVR_TWI to go back to Wire (e.g. if Wire is used for other devices). */
+/* The bus clock can be raised with U8X8_AVR_TWI_CLOCK, e.g. -DU8X8_AVR_TWI_CLOCK=800000UL */
+#if defined(U8X8_HAVE_HW_I2C) && defined(__AVR__) && defined(TWCR) && !defined(U8X8_NO_AVR_TWI)
+#define U8X8_HAVE_AVR_TWI
+#endif
+
 /* define U8X8_HAVE_2ND_HW_I2C if the board has a second wire interface*/
 #ifdef WIRE_INTERFACES_COUNT
 #if WIRE_INTERFACES_COUNT > 1
@@ -212,6 +220,8 @@ class U8X8 : public Print
 
     void draw2x2Glyph(uint8_t x, uint8_t y, uint8_t encoding) {
       u8x8_Draw2x2Glyph(&u8x8, x, y, encoding); }
+    void draw4x4Glyph(uint8_t x, uint8_t y, uint8_t encoding) {
+      u8x8_Draw4x4Glyph(&u8x8, x, y, encoding); }
 
     void drawString(uint8_t x, uint8_t y, const char *s) {
       u8x8_DrawString(&u8x8, x, y, s); }
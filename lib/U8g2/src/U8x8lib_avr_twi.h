@@ -0,0 +1,250 @@
+/*
+
+  U8x8lib_avr_twi.h
+  
+  Interrupt driven TWI master for AVR, used by u8x8_byte_arduino_hw_i2c 
+  in U8x8lib.cpp. It is a header of its own, so that a host test can 
+  compile it against emulated TWI registers.
+
+  A transfer is a list of segments. Data blocks (tile rows) are sent
+  directly from the caller's memory, only short sends (cmd/arg and
+  control bytes, which may live on the stack) are copied.
+  The START condition is generated with U8X8_MSG_BYTE_START_TRANSFER.
+  The ISR sends the segments as they are added; if it runs out of data,
+  it keeps TWINT set (SCL is held low) until the next segment arrives.
+  U8X8_MSG_BYTE_END_TRANSFER waits for the STOP condition, so all data
+  pointers stay valid for the complete transfer.
+  There is no 32 byte limit like in Wire, see u8x8_cad_ssd13xx_fast_i2c.
+  
+  A stuck bus (e.g. a slave holding SDA low) stops the ISR. The waits give 
+  up when no byte has gone out for U8X8_AVR_TWI_TIMEOUT us, reset the TWI 
+  and drop the transfer, like the timeout of Wire.
+*/
+
+#ifndef U8X8_LIB_AVR_TWI_H
+#define U8X8_LIB_AVR_TWI_H
+
+#ifndef U8X8_AVR_TWI_CLOCK
+#define U8X8_AVR_TWI_CLOCK 0	/* 0: 400kHz or 100kHz, derived from the display info */
+#endif
+
+#ifndef U8X8_AVR_TWI_TIMEOUT
+#define U8X8_AVR_TWI_TIMEOUT 25000UL	/* us without progress, same as the Wire default */
+#endif
+
+#define U8X8_AVR_TWI_SEGMENTS 4
+#define U8X8_AVR_TWI_COPY_SIZE 16
+#define U8X8_AVR_TWI_COPY_MAX 4	/* sends up to this size are copied */
+
+static uint8_t u8x8_avr_twi_adr;
+static uint8_t u8x8_avr_twi_copy[U8X8_AVR_TWI_COPY_SIZE];
+static uint8_t u8x8_avr_twi_copy_cnt;
+static const uint8_t * volatile u8x8_avr_twi_seg_ptr[U8X8_AVR_TWI_SEGMENTS];
+static volatile uint8_t u8x8_avr_twi_seg_len[U8X8_AVR_TWI_SEGMENTS];
+static volatile uint8_t u8x8_avr_twi_seg_cnt;		/* written by u8x8_avr_twi_add() */
+static volatile uint8_t u8x8_avr_twi_seg_idx;		/* written by the ISR */
+static volatile uint8_t u8x8_avr_twi_pos;
+static volatile uint8_t u8x8_avr_twi_busy;		/* START sent, STOP not yet sent */
+static volatile uint8_t u8x8_avr_twi_stalled;		/* ISR waits for more data, TWIE is off */
+static volatile uint8_t u8x8_avr_twi_end;		/* send STOP after the last segment */
+static volatile uint8_t u8x8_avr_twi_sent;		/* bytes sent, counted by the ISR */
+static uint8_t u8x8_avr_twi_last;			/* u8x8_avr_twi_sent at u8x8_avr_twi_time */
+static uint32_t u8x8_avr_twi_time;
+
+ISR(TWI_vect)
+{
+  uint8_t i;
+  switch(TW_STATUS)
+  {
+    case TW_START:
+    case TW_REP_START:
+      TWDR = u8x8_avr_twi_adr;
+      TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWIE);
+      u8x8_avr_twi_sent++;
+      break;
+    case TW_MT_SLA_ACK:
+    case TW_MT_DATA_ACK:
+      i = u8x8_avr_twi_seg_idx;
+      if ( i != u8x8_avr_twi_seg_cnt )
+      {
+	TWDR = u8x8_avr_twi_seg_ptr[i][u8x8_avr_twi_pos];
+	u8x8_avr_twi_sent++;
+	u8x8_avr_twi_pos++;
+	if ( u8x8_avr_twi_pos >= u8x8_avr_twi_seg_len[i] )
+	{
+	  u8x8_avr_twi_pos = 0;
+	  u8x8_avr_twi_seg_idx = i+1;
+	}
+	TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWIE);
+      }
+      else if ( u8x8_avr_twi_end != 0 )
+      {
+	TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWSTO);
+	u8x8_avr_twi_busy = 0;
+      }
+      else
+      {
+	/* no data yet: leave TWINT set, this holds the bus */
+	u8x8_avr_twi_stalled = 1;
+	TWCR = _BV(TWEN);
+      }
+      break;
+    default:
+      /* NACK, arbitration lost or bus error: give up this transfer */
+      TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWSTO);
+      u8x8_avr_twi_busy = 0;
+      break;
+  }
+}
+
+/* start timing a wait for the ISR */
+static void u8x8_avr_twi_wait(void)
+{
+  u8x8_avr_twi_last = u8x8_avr_twi_sent;
+  u8x8_avr_twi_time = micros();
+}
+
+/* 
+  call while waiting for the ISR: returns 1 and resets the TWI if no byte 
+  has been sent for U8X8_AVR_TWI_TIMEOUT us
+*/
+static uint8_t u8x8_avr_twi_timeout(void)
+{
+  uint8_t sreg;
+  uint8_t sent = u8x8_avr_twi_sent;
+  
+  if ( sent != u8x8_avr_twi_last )
+  {
+    u8x8_avr_twi_wait();
+    return 0;
+  }
+  if ( micros() - u8x8_avr_twi_time < U8X8_AVR_TWI_TIMEOUT )
+    return 0;
+  
+  sreg = SREG;
+  cli();
+  TWCR = 0;			/* TWEN off: aborts the transfer, releases SCL and SDA */
+  TWCR = _BV(TWEN);
+  u8x8_avr_twi_busy = 0;
+  u8x8_avr_twi_stalled = 0;
+  SREG = sreg;
+  return 1;
+}
+
+/* continue a stalled transfer, must be called with interrupts disabled */
+static void u8x8_avr_twi_resume(void)
+{
+  if ( u8x8_avr_twi_stalled != 0 )
+  {
+    u8x8_avr_twi_stalled = 0;
+    TWCR = _BV(TWEN) | _BV(TWIE);	/* TWINT is still set, so the ISR is called at once */
+  }
+}
+
+static void u8x8_avr_twi_add(uint8_t cnt, const uint8_t *ptr)
+{
+  uint8_t n, sreg;
+  uint8_t *dest;
+
+  if ( cnt == 0 )
+    return;
+  n = u8x8_avr_twi_seg_cnt;
+  if ( n >= U8X8_AVR_TWI_SEGMENTS || 
+      (cnt <= U8X8_AVR_TWI_COPY_MAX && u8x8_avr_twi_copy_cnt + cnt > U8X8_AVR_TWI_COPY_SIZE) )
+  {
+    /* out of space: wait until the ISR has sent everything, then start over */
+    u8x8_avr_twi_wait();
+    while( u8x8_avr_twi_busy != 0 && u8x8_avr_twi_stalled == 0 )
+      if ( u8x8_avr_twi_timeout() )
+	break;
+    u8x8_avr_twi_seg_idx = 0;
+    u8x8_avr_twi_pos = 0;
+    u8x8_avr_twi_seg_cnt = 0;
+    u8x8_avr_twi_copy_cnt = 0;
+    n = 0;
+  }
+  if ( u8x8_avr_twi_busy == 0 )
+    return;	/* transfer has failed */
+  
+  if ( cnt <= U8X8_AVR_TWI_COPY_MAX )
+  {
+    dest = u8x8_avr_twi_copy + u8x8_avr_twi_copy_cnt;
+    memcpy(dest, ptr, cnt);
+    u8x8_avr_twi_copy_cnt += cnt;
+    ptr = dest;
+  }
+  __asm__ __volatile__ ("" ::: "memory");
+  
+  sreg = SREG;
+  cli();
+  /* append to the previous copied segment if it has not been started yet */
+  if ( n > 0 && u8x8_avr_twi_seg_idx < n && 
+      u8x8_avr_twi_seg_ptr[n-1] + u8x8_avr_twi_seg_len[n-1] == ptr )
+  {
+    u8x8_avr_twi_seg_len[n-1] += cnt;
+  }
+  else
+  {
+    u8x8_avr_twi_seg_ptr[n] = ptr;
+    u8x8_avr_twi_seg_len[n] = cnt;
+    u8x8_avr_twi_seg_cnt = n+1;
+  }
+  u8x8_avr_twi_resume();
+  SREG = sreg;
+}
+
+static void u8x8_avr_twi_init(u8x8_t *u8x8)
+{
+  uint32_t clock = U8X8_AVR_TWI_CLOCK;
+  uint32_t twbr;
+  
+  if ( clock == 0 )
+    clock = u8x8->display_info->i2c_bus_clock_100kHz >= 4 ? 400000UL : 100000UL;
+  twbr = F_CPU / clock;
+  twbr = twbr > 16 ? (twbr - 16) / 2 : 0;
+  if ( twbr > 255 )
+    twbr = 255;
+  
+  /* internal pullups, same as Wire */
+  digitalWrite(SDA, HIGH);
+  digitalWrite(SCL, HIGH);
+  
+  TWSR = 0;			/* prescaler 1 */
+  TWBR = (uint8_t)twbr;
+  TWCR = _BV(TWEN);
+}
+
+static void u8x8_avr_twi_start(u8x8_t *u8x8)
+{
+  /* the previous transfer is always finished here, but the STOP might still be on the bus */
+  u8x8_avr_twi_wait();
+  while( TWCR & _BV(TWSTO) )
+    if ( u8x8_avr_twi_timeout() )
+      break;
+  u8x8_avr_twi_adr = u8x8_GetI2CAddress(u8x8) & 0x0fe;		/* TW_WRITE */
+  u8x8_avr_twi_seg_idx = 0;
+  u8x8_avr_twi_pos = 0;
+  u8x8_avr_twi_seg_cnt = 0;
+  u8x8_avr_twi_copy_cnt = 0;
+  u8x8_avr_twi_stalled = 0;
+  u8x8_avr_twi_end = 0;
+  u8x8_avr_twi_busy = 1;
+  TWCR = _BV(TWINT) | _BV(TWEN) | _BV(TWIE) | _BV(TWSTA);
+}
+
+static void u8x8_avr_twi_stop(void)
+{
+  uint8_t sreg;
+  
+  sreg = SREG;
+  cli();
+  u8x8_avr_twi_end = 1;
+  u8x8_avr_twi_resume();
+  SREG = sreg;
+  u8x8_avr_twi_wait();
+  while( u8x8_avr_twi_busy != 0 )
+    if ( u8x8_avr_twi_timeout() )
+      break;
+}
+
+#endif /* U8X8_LIB_AVR_TWI_H */
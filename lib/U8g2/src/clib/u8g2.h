@@ -147,6 +147,46 @@
 */
 #define U8G2_WITH_CLIPPING
 
+/*
+  The following macro enables the tracking of changed tiles in the buffer.
+  The low level hvline procedure of the SSD13xx and UC1701 buffer layout
+  (u8g2_ll_hvline_vertical_top_lsb) and u8g2_ClearBuffer() remember which 
+  tiles got a new value, and u8g2_SendDirtyBuffer() will only transfer 
+  those tiles to the display. It requires U8G2_DIRTY_TILE_ROWS*2 bytes of RAM.
+  Tile rows and columns beyond U8G2_DIRTY_TILE_ROWS and 16 share the 
+  flag of the last row and column.
+  It is off by default, enable it with -DU8G2_WITH_DIRTY_TILES.
+*/
+//#define U8G2_WITH_DIRTY_TILES
+#ifndef U8G2_DIRTY_TILE_ROWS
+#define U8G2_DIRTY_TILE_ROWS 8
+#endif
+
+/*
+  The following macro enables an optional glyph cache. After 
+  u8g2_SetGlyphCache() has been called with a RAM area and a font, the 
+  glyphs of this font are decoded once into the RAM area in the byte 
+  layout of u8g2_ll_hvline_vertical_top_lsb and are then copied into 
+  the buffer with byte operations instead of decoding the run length code.
+  The cache is used for R0 and font direction 0 only. If the RAM area is
+  full, it is cleared and filled again. Each glyph requires 6 + 
+  width*((height+7)/8) bytes.
+  It is off by default, enable it with -DU8G2_WITH_GLYPH_CACHE.
+*/
+//#define U8G2_WITH_GLYPH_CACHE
+
+/*
+  The following macro adds an index of the printable ASCII glyphs (32..126)
+  of one font. u8g2_SetFontIndex() builds it for the given font, and while
+  this is the current font, u8g2_font_get_glyph_data() is a single table 
+  read for these characters. Other fonts are searched as before, so a 
+  font switch never rebuilds the index. It requires 2*95 bytes of RAM.
+  It is off by default, enable it with -DU8G2_WITH_FONT_INDEX.
+*/
+//#define U8G2_WITH_FONT_INDEX
+#define U8G2_FONT_INDEX_FIRST 32
+#define U8G2_FONT_INDEX_CNT 95
+
 
 
 
@@ -342,6 +382,19 @@ struct u8g2_struct
 #ifdef U8G2_WITH_HVLINE_COUNT
   unsigned long hv_cnt;
 #endif /* U8G2_WITH_HVLINE_COUNT */   
+#ifdef U8G2_WITH_DIRTY_TILES
+  uint16_t dirty_tiles[U8G2_DIRTY_TILE_ROWS];	/* one bit per tile, set if the tile needs to be sent */
+#endif /* U8G2_WITH_DIRTY_TILES */
+#ifdef U8G2_WITH_GLYPH_CACHE
+  uint8_t *glyph_cache;			/* RAM area for decoded glyphs, NULL: no cache */
+  const uint8_t *glyph_cache_font;	/* font of the glyphs in the cache */
+  uint16_t glyph_cache_size;
+  uint16_t glyph_cache_used;
+#endif /* U8G2_WITH_GLYPH_CACHE */
+#ifdef U8G2_WITH_FONT_INDEX
+  const uint8_t *font_index_font;	/* font of font_index, NULL: no index */
+  uint16_t font_index[U8G2_FONT_INDEX_CNT];	/* offset of the glyph data in the font, 0: no glyph */
+#endif /* U8G2_WITH_FONT_INDEX */
 #ifdef __unix__
   uint16_t last_unicode;
   const uint8_t *last_font_data;
@@ -862,7 +915,10 @@ void u8g2_Setup_a2printer_384x240_f(u8g2_t *u8g2, const u8g2_cb_t *rotation, u8x
 /* u8g2_buffer.c */
 
 void u8g2_SendBuffer(u8g2_t *u8g2);
+void u8g2_SendDirtyBuffer(u8g2_t *u8g2);
+uint8_t u8g2_SendBufferStep(u8g2_t *u8g2);
 void u8g2_ClearBuffer(u8g2_t *u8g2);
+void u8g2_SetBufferDirty(u8g2_t *u8g2, uint8_t is_dirty);
 
 void u8g2_SetBufferCurrTileRow(u8g2_t *u8g2, uint8_t row) U8G2_NOINLINE;
 
@@ -877,6 +933,13 @@ uint8_t u8g2_NextPage(u8g2_t *u8g2);
 #define u8g2_GetPageCurrTileRow(u8g2) ((u8g2)->tile_curr_row)
 #define u8g2_GetBufferCurrTileRow(u8g2) ((u8g2)->tile_curr_row)
 
+#ifdef U8G2_WITH_DIRTY_TILES
+/* x, y are tile positions within the buffer */
+#define u8g2_MarkDirtyTile(u8g2, x, y) \
+  ((u8g2)->dirty_tiles[(y) < U8G2_DIRTY_TILE_ROWS ? (y) : U8G2_DIRTY_TILE_ROWS-1] |= \
+    (uint16_t)1 << ((x) < 16 ? (x) : 15))
+#endif
+
 /*==========================================*/
 /* u8g2_ll_hvline.c */
 /*
@@ -976,6 +1039,12 @@ size_t u8g2_GetFontSize(const uint8_t *font_arg);
 
 void u8g2_SetFont(u8g2_t *u8g2, const uint8_t  *font);
 void u8g2_SetFontMode(u8g2_t *u8g2, uint8_t is_transparent);
+#ifdef U8G2_WITH_GLYPH_CACHE
+void u8g2_SetGlyphCache(u8g2_t *u8g2, uint8_t *buf, uint16_t size, const uint8_t *font);
+#endif /* U8G2_WITH_GLYPH_CACHE */
+#ifdef U8G2_WITH_FONT_INDEX
+void u8g2_SetFontIndex(u8g2_t *u8g2, const uint8_t *font);
+#endif /* U8G2_WITH_FONT_INDEX */
 
 uint8_t u8g2_IsGlyph(u8g2_t *u8g2, uint16_t requested_encoding);
 int8_t u8g2_GetGlyphWidth(u8g2_t *u8g2, uint16_t requested_encoding);
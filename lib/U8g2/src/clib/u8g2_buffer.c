@@ -40,12 +40,46 @@
 void u8g2_ClearBuffer(u8g2_t *u8g2)
 {
   size_t cnt;
+#ifdef U8G2_WITH_DIRTY_TILES
+  uint8_t *ptr;
+  uint8_t x, y, i;
+  
+  /* a tile will change, if it is not already empty */
+  ptr = u8g2->tile_buf_ptr;
+  for( y = 0; y < u8g2->tile_buf_height; y++ )
+  {
+    for( x = 0; x < u8g2_GetU8x8(u8g2)->display_info->tile_width; x++ )
+    {
+      for( i = 0; i < 8; i++ )
+      {
+	if ( ptr[i] != 0 )
+	{
+	  u8g2_MarkDirtyTile(u8g2, x, y);
+	  break;
+	}
+      }
+      ptr += 8;
+    }
+  }
+#endif /* U8G2_WITH_DIRTY_TILES */
   cnt = u8g2_GetU8x8(u8g2)->display_info->tile_width;
   cnt *= u8g2->tile_buf_height;
   cnt *= 8;
   memset(u8g2->tile_buf_ptr, 0, cnt);
 }
 
+/*
+  is_dirty = 1: all tiles will be sent by the next u8g2_SendDirtyBuffer(),
+    use this if the display RAM has been modified by other means
+  is_dirty = 0: assume that the display already shows the buffer
+*/
+void u8g2_SetBufferDirty(u8g2_t *u8g2, uint8_t is_dirty)
+{
+#ifdef U8G2_WITH_DIRTY_TILES
+  memset(u8g2->dirty_tiles, is_dirty ? 0x0ff : 0, sizeof(u8g2->dirty_tiles));
+#endif /* U8G2_WITH_DIRTY_TILES */
+}
+
 /*============================================*/
 
 static void u8g2_send_tile_row(u8g2_t *u8g2, uint8_t src_tile_row, uint8_t dest_tile_row)
@@ -87,6 +121,9 @@ static void u8g2_send_buffer(u8g2_t *u8g2)
     src_row++;
     dest_row++;
   } while( src_row < src_max && dest_row < dest_max );
+  
+  /* everything is on the display now */
+  u8g2_SetBufferDirty(u8g2, 0);
 }
 
 /* same as u8g2_send_buffer but also send the DISPLAY_REFRESH message (used by SSD1606) */
@@ -96,6 +133,121 @@ void u8g2_SendBuffer(u8g2_t *u8g2)
   u8x8_RefreshDisplay( u8g2_GetU8x8(u8g2) );  
 }
 
+#ifdef U8G2_WITH_DIRTY_TILES
+/* send the runs of dirty tiles of one tile row */
+static void u8g2_send_dirty_tile_row(u8g2_t *u8g2, uint8_t src_tile_row, uint8_t dest_tile_row)
+{
+  uint8_t *ptr;
+  uint16_t offset;
+  uint16_t dirty;
+  uint8_t w, x, cnt;
+  
+  w = u8g2_GetU8x8(u8g2)->display_info->tile_width;
+  offset = src_tile_row;
+  ptr = u8g2->tile_buf_ptr;
+  offset *= w;
+  offset *= 8;
+  ptr += offset;
+  
+  dirty = u8g2->dirty_tiles[src_tile_row < U8G2_DIRTY_TILE_ROWS ? src_tile_row : U8G2_DIRTY_TILE_ROWS-1];
+  
+  x = 0;
+  while( x < w )
+  {
+    cnt = 0;
+    while( x+cnt < w && (dirty & ((uint16_t)1 << (x+cnt < 16 ? x+cnt : 15))) )
+      cnt++;
+    if ( cnt == 0 )
+    {
+      x++;
+    }
+    else
+    {
+      u8x8_DrawTile(u8g2_GetU8x8(u8g2), x, dest_tile_row, cnt, ptr+x*8);
+      x += cnt;
+    }
+  }
+}
+#endif /* U8G2_WITH_DIRTY_TILES */
+
+/* 
+  same as u8g2_SendBuffer, but only transfer the tiles which have been 
+  changed since the last transfer.
+  Only available for the full buffer and the vertical_top_lsb (SSD13xx) 
+  layout, otherwise the complete buffer is sent.
+*/
+void u8g2_SendDirtyBuffer(u8g2_t *u8g2)
+{
+#ifdef U8G2_WITH_DIRTY_TILES
+  uint8_t row;
+  uint8_t row_max;
+  
+  row_max = u8g2_GetU8x8(u8g2)->display_info->tile_height;
+  if ( u8g2->ll_hvline != u8g2_ll_hvline_vertical_top_lsb || u8g2->tile_buf_height < row_max )
+  {
+    u8g2_SendBuffer(u8g2);
+    return;
+  }
+  
+  for( row = 0; row < row_max; row++ )
+    u8g2_send_dirty_tile_row(u8g2, row, row);
+  u8g2_SetBufferDirty(u8g2, 0);
+  u8x8_RefreshDisplay( u8g2_GetU8x8(u8g2) );  
+#else
+  u8g2_SendBuffer(u8g2);
+#endif /* U8G2_WITH_DIRTY_TILES */
+}
+
+/* 
+  incremental version of u8g2_SendDirtyBuffer: send the dirty tiles of one 
+  tile row only, so that the application can do other work between the 
+  calls. Returns 1 as long as there are dirty tiles left.
+  Drawing between the calls is allowed: It marks the tiles dirty again, 
+  so they are sent by one of the next calls and the display always ends 
+  up with the latest content of the buffer.
+  Without dirty tile support, the complete buffer is sent and 0 is returned.
+*/
+uint8_t u8g2_SendBufferStep(u8g2_t *u8g2)
+{
+#ifdef U8G2_WITH_DIRTY_TILES
+  uint8_t row;
+  uint8_t row_max;
+  uint8_t i;
+  
+  row_max = u8g2_GetU8x8(u8g2)->display_info->tile_height;
+  if ( u8g2->ll_hvline != u8g2_ll_hvline_vertical_top_lsb || u8g2->tile_buf_height < row_max )
+  {
+    u8g2_SendBuffer(u8g2);
+    return 0;
+  }
+  
+  for( row = 0; row < row_max; row++ )
+  {
+    i = row < U8G2_DIRTY_TILE_ROWS ? row : U8G2_DIRTY_TILE_ROWS-1;
+    if ( u8g2->dirty_tiles[i] != 0 )
+    {
+      /* the last flag is shared by all remaining rows */
+      do
+      {
+	u8g2_send_dirty_tile_row(u8g2, row, row);
+	row++;
+      } while( i == U8G2_DIRTY_TILE_ROWS-1 && row < row_max );
+      u8g2->dirty_tiles[i] = 0;
+      
+      for( i = 0; i < U8G2_DIRTY_TILE_ROWS; i++ )
+	if ( u8g2->dirty_tiles[i] != 0 )
+	  return 1;
+      u8x8_RefreshDisplay( u8g2_GetU8x8(u8g2) );  
+      return 0;
+    }
+  }
+  return 0;
+#else
+  u8g2_SendBuffer(u8g2);
+  return 0;
+#endif /* U8G2_WITH_DIRTY_TILES */
+}
+
 /*============================================*/
 void u8g2_SetBufferCurrTileRow(u8g2_t *u8g2, uint8_t row)
 {
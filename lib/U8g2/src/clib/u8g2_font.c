@@ -34,6 +34,7 @@
 */
 
 #include "u8g2.h"
+#include <string.h>
 
 /* size of the font data structure, there is no struct or class... */
 /* this is the size for the new font format */
@@ -586,11 +587,54 @@ int8_t u8g2_font_decode_glyph(u8g2_t *u8g2, const uint8_t *glyph_data)
   Return:
     Address of the glyph data or NULL, if the encoding is not avialable in the font.
 */
+#ifdef U8G2_WITH_FONT_INDEX
+/* 
+  walk once through the 8 bit glyphs of font and remember the glyph data 
+  offsets, font NULL removes the index
+*/
+void u8g2_SetFontIndex(u8g2_t *u8g2, const uint8_t *font)
+{
+  const uint8_t *glyph;
+  uint8_t e, i;
+  
+  if ( u8g2->font_index_font == font )
+    return;
+  u8g2->font_index_font = font;
+  if ( font == NULL )
+    return;
+  
+  for( i = 0; i < U8G2_FONT_INDEX_CNT; i++ )
+    u8g2->font_index[i] = 0;
+  glyph = font + U8G2_FONT_DATA_STRUCT_SIZE;
+  for(;;)
+  {
+    if ( u8x8_pgm_read( glyph + 1 ) == 0 )
+      break;
+    e = u8x8_pgm_read( glyph );
+    e -= U8G2_FONT_INDEX_FIRST;
+    if ( e < U8G2_FONT_INDEX_CNT )
+      u8g2->font_index[e] = glyph + 2 - font;	/* skip encoding and glyph size */
+    glyph += u8x8_pgm_read( glyph + 1 );
+  }
+}
+#endif /* U8G2_WITH_FONT_INDEX */
+
 const uint8_t *u8g2_font_get_glyph_data(u8g2_t *u8g2, uint16_t encoding)
 {
   const uint8_t *font = u8g2->font;
   font += U8G2_FONT_DATA_STRUCT_SIZE;
 
+#ifdef U8G2_WITH_FONT_INDEX
+  if ( u8g2->font_index_font == u8g2->font && 
+      encoding >= U8G2_FONT_INDEX_FIRST && encoding < U8G2_FONT_INDEX_FIRST+U8G2_FONT_INDEX_CNT )
+  {
+    uint16_t offset;
+    offset = u8g2->font_index[encoding - U8G2_FONT_INDEX_FIRST];
+    if ( offset == 0 )
+      return NULL;
+    return u8g2->font + offset;
+  }
+#endif /* U8G2_WITH_FONT_INDEX */
   
   if ( encoding <= 255 )
   {
@@ -660,6 +704,266 @@ const uint8_t *u8g2_font_get_glyph_data(u8g2_t *u8g2, uint16_t encoding)
   return NULL;
 }
 
+#ifdef U8G2_WITH_GLYPH_CACHE
+
+/*
+  Glyph cache entry:
+    0: encoding
+    1: glyph width
+    2: glyph height
+    3: x offset
+    4: y offset
+    5: delta x
+    6..: width*((height+7)/8) bytes, column by column, lsb on top
+*/
+#define U8G2_GLYPH_CACHE_HDR 6
+
+void u8g2_SetGlyphCache(u8g2_t *u8g2, uint8_t *buf, uint16_t size, const uint8_t *font)
+{
+  u8g2->glyph_cache = buf;
+  u8g2->glyph_cache_size = size;
+  u8g2->glyph_cache_used = 0;
+  u8g2->glyph_cache_font = font;
+}
+
+static uint8_t *u8g2_glyph_cache_find(u8g2_t *u8g2, uint8_t encoding)
+{
+  uint8_t *e = u8g2->glyph_cache;
+  uint8_t *end = e + u8g2->glyph_cache_used;
+  while( e < end )
+  {
+    if ( e[0] == encoding )
+      return e;
+    e += U8G2_GLYPH_CACHE_HDR + (uint16_t)e[1] * ((e[2]+7)>>3);
+  }
+  return NULL;
+}
+
+/* same as u8g2_font_decode_len(), but sets the foreground bits in the cache entry */
+static void u8g2_glyph_cache_decode_len(u8g2_font_decode_t *decode, uint8_t *data, uint8_t len, uint8_t is_foreground)
+{
+  uint8_t cnt, rem, current;
+  uint8_t lx, ly, mask, bytes_per_col;
+  uint8_t *ptr;
+  
+  bytes_per_col = (decode->glyph_height+7)>>3;
+  cnt = len;
+  lx = decode->x;
+  ly = decode->y;
+  for(;;)
+  {
+    rem = decode->glyph_width;
+    rem -= lx;
+    current = rem;
+    if ( cnt < rem )
+      current = cnt;
+    if ( is_foreground )
+    {
+      mask = 1 << (ly & 7);
+      ptr = data + (uint16_t)lx * bytes_per_col + (ly >> 3);
+      while( current > 0 )
+      {
+	*ptr |= mask;
+	ptr += bytes_per_col;
+	current--;
+      }
+    }
+    if ( cnt < rem )
+      break;
+    cnt -= rem;
+    lx = 0;
+    ly++;
+  }
+  lx += cnt;
+  decode->x = lx;
+  decode->y = ly;
+}
+
+/* decode the glyph into a new cache entry, returns NULL if it does not fit */
+static uint8_t *u8g2_glyph_cache_add(u8g2_t *u8g2, uint8_t encoding, const uint8_t *glyph_data)
+{
+  uint8_t a, b;
+  uint8_t *e;
+  uint8_t *data;
+  uint16_t size;
+  u8g2_font_decode_t *decode = &(u8g2->font_decode);
+  
+  u8g2_font_setup_decode(u8g2, glyph_data);
+  size = (uint16_t)decode->glyph_width * ((decode->glyph_height+7)>>3);
+  size += U8G2_GLYPH_CACHE_HDR;
+  if ( size > u8g2->glyph_cache_size )
+    return NULL;
+  if ( u8g2->glyph_cache_used + size > u8g2->glyph_cache_size )
+    u8g2->glyph_cache_used = 0;		/* full: start again */
+  
+  e = u8g2->glyph_cache + u8g2->glyph_cache_used;
+  e[0] = encoding;
+  e[1] = decode->glyph_width;
+  e[2] = decode->glyph_height;
+  e[3] = u8g2_font_decode_get_signed_bits(decode, u8g2->font_info.bits_per_char_x);
+  e[4] = u8g2_font_decode_get_signed_bits(decode, u8g2->font_info.bits_per_char_y);
+  e[5] = u8g2_font_decode_get_signed_bits(decode, u8g2->font_info.bits_per_delta_x);
+  data = e + U8G2_GLYPH_CACHE_HDR;
+  memset(data, 0, size - U8G2_GLYPH_CACHE_HDR);
+  
+  if ( decode->glyph_width > 0 )
+  {
+    decode->x = 0;
+    decode->y = 0;
+    for(;;)
+    {
+      a = u8g2_font_decode_get_unsigned_bits(decode, u8g2->font_info.bits_per_0);
+      b = u8g2_font_decode_get_unsigned_bits(decode, u8g2->font_info.bits_per_1);
+      do
+      {
+	u8g2_glyph_cache_decode_len(decode, data, a, 0);
+	u8g2_glyph_cache_decode_len(decode, data, b, 1);
+      } while( u8g2_font_decode_get_unsigned_bits(decode, 1) != 0 );
+
+      if ( decode->y >= decode->glyph_height )
+	break;
+    }
+  }
+  u8g2->glyph_cache_used += size;
+  return e;
+}
+
+/* 
+  combine one byte row of the glyph with one tile row of the buffer
+  src: first byte of the row in the cache entry, the next column is at src+stride
+  shift: vertical shift of the glyph bits, "upper" selects the bits which 
+    are shifted into the next tile row
+  valid: pixel of the glyph box in the shifted byte
+*/
+static void u8g2_glyph_cache_draw_row(u8g2_t *u8g2, int16_t row, u8g2_uint_t x, const uint8_t *src, uint8_t stride, uint8_t w, uint8_t shift, uint8_t upper, uint8_t valid)
+{
+  u8g2_font_decode_t *decode = &(u8g2->font_decode);
+  uint8_t *ptr;
+  uint8_t b, bits, changed;
+  uint16_t v;
+  
+  if ( row < 0 || row >= u8g2->tile_buf_height || valid == 0 )
+    return;
+  ptr = u8g2->tile_buf_ptr;
+  ptr += (uint16_t)row * u8g2_GetU8x8(u8g2)->display_info->tile_width * 8;
+  ptr += x;
+  changed = 0;
+  do
+  {
+    v = *src;
+    v <<= shift;
+    bits = upper ? v >> 8 : v;
+    b = *ptr;
+    if ( decode->is_transparent == 0 )
+    {
+      /* background pixel, bg_color is 0 or 1 */
+      if ( decode->bg_color != 0 )
+	b |= valid & ~bits;
+      else
+	b &= ~valid | bits;
+    }
+    if ( decode->fg_color == 0 )
+      b &= ~bits;
+    else if ( decode->fg_color == 1 )
+      b |= bits;
+    else
+      b ^= bits;
+    changed |= b ^ *ptr;
+    *ptr = b;
+#ifdef U8G2_WITH_DIRTY_TILES
+    if ( (x & 7) == 7 || w == 1 )
+    {
+      if ( changed != 0 )
+	u8g2_MarkDirtyTile(u8g2, x >> 3, row);
+      changed = 0;
+    }
+#endif /* U8G2_WITH_DIRTY_TILES */
+    x++;
+    ptr++;
+    src += stride;
+    w--;
+  } while( w != 0 );
+}
+
+/* copy a cache entry to the buffer at font_decode.target_x/y, returns delta x */
+static int8_t u8g2_glyph_cache_draw(u8g2_t *u8g2, const uint8_t *e)
+{
+  u8g2_font_decode_t *decode = &(u8g2->font_decode);
+  const uint8_t *data = e + U8G2_GLYPH_CACHE_HDR;
+  uint8_t w = e[1];
+  uint8_t h = e[2];
+  uint8_t bytes_per_col = (h+7)>>3;
+  uint8_t shift, i;
+  uint16_t valid;
+  int16_t y, row;
+  u8g2_uint_t x;
+  
+  if ( w == 0 )
+    return (int8_t)e[5];
+  
+  x = decode->target_x + (int8_t)e[3];
+  y = (u8g2_uint_t)(decode->target_y - (h + (int8_t)e[4]));
+  y -= u8g2->tile_curr_row*8;
+  shift = y & 7;
+  row = (y - shift) / 8;
+  
+  decode->fg_color = u8g2->draw_color;
+  decode->bg_color = (decode->fg_color == 0 ? 1 : 0);
+  
+  for( i = 0; i < bytes_per_col; i++ )
+  {
+    valid = 0x0ff;
+    if ( i+1 == bytes_per_col )
+      valid >>= (8 - (h & 7)) & 7;
+    valid <<= shift;
+    u8g2_glyph_cache_draw_row(u8g2, row+i, x, data+i, bytes_per_col, w, shift, 0, valid);
+    if ( shift != 0 )
+      u8g2_glyph_cache_draw_row(u8g2, row+i+1, x, data+i, bytes_per_col, w, shift, 1, valid >> 8);
+  }
+  return (int8_t)e[5];
+}
+
+/* returns NULL if the glyph can not be drawn from the cache */
+static const uint8_t *u8g2_glyph_cache_get(u8g2_t *u8g2, uint16_t encoding)
+{
+  const uint8_t *glyph_data;
+  uint8_t *e;
+  
+  if ( u8g2->glyph_cache == NULL || u8g2->glyph_cache_font != u8g2->font || encoding > 255 )
+    return NULL;
+  if ( u8g2->ll_hvline != u8g2_ll_hvline_vertical_top_lsb || u8g2->cb != U8G2_R0 || u8g2->draw_color > 2 )
+    return NULL;
+#ifdef U8G2_WITH_FONT_ROTATION
+  if ( u8g2->font_decode.dir != 0 )
+    return NULL;
+#endif
+  e = u8g2_glyph_cache_find(u8g2, encoding);
+  if ( e == NULL )
+  {
+    glyph_data = u8g2_font_get_glyph_data(u8g2, encoding);
+    if ( glyph_data == NULL )
+      return NULL;
+    e = u8g2_glyph_cache_add(u8g2, encoding, glyph_data);
+    if ( e == NULL )
+      return NULL;
+  }
+  /* the glyph must be within the buffer width and must not wrap around at the */
+  /* top of the coordinate range, otherwise use the clipping of the decoder */
+  if ( e[1] > 0 )
+  {
+    u8g2_uint_t x, y;
+    x = u8g2->font_decode.target_x + (int8_t)e[3];
+    y = u8g2->font_decode.target_y - (e[2] + (int8_t)e[4]);
+    if ( (uint16_t)x + e[1] > u8g2->pixel_buf_width )
+      return NULL;
+    if ( (u8g2_uint_t)(y + e[2]) < y )
+      return NULL;
+  }
+  return e;
+}
+
+#endif /* U8G2_WITH_GLYPH_CACHE */
+
 static u8g2_uint_t u8g2_font_draw_glyph(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y, uint16_t encoding)
 {
   u8g2_uint_t dx = 0;
@@ -667,6 +971,11 @@ static u8g2_uint_t u8g2_font_draw_glyph(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t
   u8g2->font_decode.target_y = y;
   //u8g2->font_decode.is_transparent = is_transparent; this is already set
   //u8g2->font_decode.dir = dir;
+#ifdef U8G2_WITH_GLYPH_CACHE
+  const uint8_t *e = u8g2_glyph_cache_get(u8g2, encoding);
+  if ( e != NULL )
+    return u8g2_glyph_cache_draw(u8g2, e);
+#endif /* U8G2_WITH_GLYPH_CACHE */
   const uint8_t *glyph_data = u8g2_font_get_glyph_data(u8g2, encoding);
   if ( glyph_data != NULL )
   {
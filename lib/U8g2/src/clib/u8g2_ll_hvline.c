@@ -75,6 +75,9 @@ void u8g2_ll_hvline_vertical_top_lsb(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y,
   uint8_t *ptr;
   uint8_t bit_pos, mask;
   uint8_t or_mask, xor_mask;
+#ifdef U8G2_WITH_DIRTY_TILES
+  uint8_t b, changed, tile_row;
+#endif /* U8G2_WITH_DIRTY_TILES */
 
   //assert(x >= u8g2->buf_x0);
   //assert(x < u8g2_GetU8x8(u8g2)->display_info->tile_width*8);
@@ -102,12 +105,33 @@ void u8g2_ll_hvline_vertical_top_lsb(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y,
   ptr += offset;
   ptr += x;
   
+#ifdef U8G2_WITH_DIRTY_TILES
+  /* only tiles with a different value need to be sent again */
+  changed = 0;
+  tile_row = y >> 3;
+#endif /* U8G2_WITH_DIRTY_TILES */
+
   if ( dir == 0 )
   {
       do
       {
+#ifdef U8G2_WITH_DIRTY_TILES
+	b = *ptr;
+	b |= or_mask;
+	b ^= xor_mask;
+	changed |= b ^ *ptr;
+	*ptr = b;
+	if ( (x & 7) == 7 || len == 1 )
+	{
+	  if ( changed != 0 )
+	    u8g2_MarkDirtyTile(u8g2, x >> 3, tile_row);
+	  changed = 0;
+	}
+	x++;
+#else
 	*ptr |= or_mask;
 	*ptr ^= xor_mask;
+#endif /* U8G2_WITH_DIRTY_TILES */
 	ptr++;
 	len--;
       } while( len != 0 );
@@ -116,8 +140,19 @@ void u8g2_ll_hvline_vertical_top_lsb(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y,
   {    
     do
     {
+#ifdef U8G2_WITH_DIRTY_TILES
+      b = *ptr;
+      b |= or_mask;
+      b ^= xor_mask;
+      if ( b != *ptr )
+      {
+	*ptr = b;
+	u8g2_MarkDirtyTile(u8g2, x >> 3, tile_row);
+      }
+#else
       *ptr |= or_mask;
       *ptr ^= xor_mask;
+#endif /* U8G2_WITH_DIRTY_TILES */
       
       bit_pos++;
       bit_pos &= 7;
@@ -127,6 +162,9 @@ void u8g2_ll_hvline_vertical_top_lsb(u8g2_t *u8g2, u8g2_uint_t x, u8g2_uint_t y,
       if ( bit_pos == 0 )
       {
 	ptr+=u8g2->pixel_buf_width;	/* 6 Jan 17: Changed u8g2->width to u8g2->pixel_buf_width, issue #148 */
+#ifdef U8G2_WITH_DIRTY_TILES
+	tile_row++;
+#endif /* U8G2_WITH_DIRTY_TILES */
 		
 	if ( u8g2->draw_color <= 1 )
 	  or_mask  = 1;
@@ -154,6 +192,9 @@ static void u8g2_draw_pixel_vertical_top_lsb(u8g2_t *u8g2, u8g2_uint_t x, u8g2_u
   uint16_t offset;
   uint8_t *ptr;
   uint8_t bit_pos, mask;
+#ifdef U8G2_WITH_DIRTY_TILES
+  uint8_t old;
+#endif /* U8G2_WITH_DIRTY_TILES */
   
   //assert(x >= u8g2->buf_x0);
   //assert(x < u8g2_GetU8x8(u8g2)->display_info->tile_width*8);
@@ -173,12 +214,19 @@ static void u8g2_draw_pixel_vertical_top_lsb(u8g2_t *u8g2, u8g2_uint_t x, u8g2_u
   ptr += offset;
   ptr += x;
 
+#ifdef U8G2_WITH_DIRTY_TILES
+  old = *ptr;
+#endif /* U8G2_WITH_DIRTY_TILES */
 
   if ( u8g2->draw_color <= 1 )
     *ptr |= mask;
   if ( u8g2->draw_color != 1 )
     *ptr ^= mask;
 
+#ifdef U8G2_WITH_DIRTY_TILES
+  if ( old != *ptr )
+    u8g2_MarkDirtyTile(u8g2, x >> 3, y >> 3);
+#endif /* U8G2_WITH_DIRTY_TILES */
 }
 
 /*
@@ -54,6 +54,13 @@ void u8g2_SetupBuffer(u8g2_t *u8g2, uint8_t *buf, uint8_t tile_buf_height, u8g2_
   u8g2->tile_buf_height = tile_buf_height;
   
   u8g2->tile_curr_row = 0;
+  u8g2_SetBufferDirty(u8g2, 1);	/* display content is unknown */
+#ifdef U8G2_WITH_GLYPH_CACHE
+  u8g2->glyph_cache = NULL;
+#endif /* U8G2_WITH_GLYPH_CACHE */
+#ifdef U8G2_WITH_FONT_INDEX
+  u8g2->font_index_font = NULL;
+#endif /* U8G2_WITH_FONT_INDEX */
   
   u8g2->font_decode.is_transparent = 0; /* issue 443 */
   u8g2->bitmap_transparency = 0;
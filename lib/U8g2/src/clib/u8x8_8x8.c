@@ -156,11 +156,12 @@ static void u8x8_upscale_buf(uint8_t *src, uint8_t *dest)
   } while( i > 0 );
 }
 
+/* both tiles of a row go out in one u8x8_DrawTile(), which halves the bus transfers */
 void u8x8_Draw2x2Glyph(u8x8_t *u8x8, uint8_t x, uint8_t y, uint8_t encoding)
 {
   uint8_t i;
   uint16_t t;
-  uint8_t buf[8];
+  uint8_t buf[16];
   uint8_t buf1[8];
   uint8_t buf2[8];
   u8x8_get_glyph_data(u8x8, encoding, buf);
@@ -171,16 +172,35 @@ void u8x8_Draw2x2Glyph(u8x8_t *u8x8, uint8_t x, uint8_t y, uint8_t encoding)
       buf2[i] = t & 255;
   }
   u8x8_upscale_buf(buf2, buf);
-  u8x8_DrawTile(u8x8, x, y, 1, buf);
-  
-  u8x8_upscale_buf(buf2+4, buf);
-  u8x8_DrawTile(u8x8, x+1, y, 1, buf);
+  u8x8_upscale_buf(buf2+4, buf+8);
+  u8x8_DrawTile(u8x8, x, y, 2, buf);
   
   u8x8_upscale_buf(buf1, buf);
-  u8x8_DrawTile(u8x8, x, y+1, 1, buf);
-  
-  u8x8_upscale_buf(buf1+4, buf);
-  u8x8_DrawTile(u8x8, x+1, y+1, 1, buf);  
+  u8x8_upscale_buf(buf1+4, buf+8);
+  u8x8_DrawTile(u8x8, x, y+1, 2, buf);
+}
+
+/* 
+  4x upscaled glyph, 4x4 tiles (32x32 pixel). Tile row j shows the 
+  glyph bits 2j and 2j+1, each one four pixel high and wide.
+*/
+void u8x8_Draw4x4Glyph(u8x8_t *u8x8, uint8_t x, uint8_t y, uint8_t encoding)
+{
+  uint8_t i, j, b;
+  uint8_t buf[8];
+  uint8_t row[32];
+  u8x8_get_glyph_data(u8x8, encoding, buf);
+  for( j = 0; j < 4; j++ )
+  {
+    for( i = 0; i < 32; i++ )
+    {
+      b = buf[i >> 2];
+      row[i] = ((b & 1) ? 0x0f : 0) | ((b & 2) ? 0xf0 : 0);
+    }
+    for( i = 0; i < 8; i++ )
+      buf[i] >>= 2;
+    u8x8_DrawTile(u8x8, x, y+j, 4, row);
+  }
 }
 
 
@@ -177,6 +177,22 @@ static uint8_t u8x8_d_ssd1306_128x32_generic(u8x8_t *u8x8, uint8_t msg, uint8_t
 }
 
 
+/*
+  Vertical scrolling with the start line register: The display RAM has 64 
+  lines (8 tile rows), the display shows 32 of them, from the start line 
+  on and wrapping around at line 63. Tile rows 4 to 7 are written with 
+  u8x8_DrawTile() like the visible ones. Moving the start line one line 
+  at a time scrolls smoothly with a single command byte on the bus.
+  u8g2 always draws rows 0 to 3, so set the start line back to 0 before 
+  drawing with u8g2 again.
+*/
+void u8x8_ssd1306_128x32_SetStartLine(u8x8_t *u8x8, uint8_t line)
+{
+  u8x8_cad_StartTransfer(u8x8);
+  u8x8_cad_SendCmd(u8x8, 0x040 | (line & 63));	/* set display start line */
+  u8x8_cad_EndTransfer(u8x8);
+}
+
 static const u8x8_display_info_t u8x8_ssd1306_128x32_univision_display_info =
 {
   /* chip_enable_level = */ 0,
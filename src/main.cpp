@@ -34,15 +34,22 @@
 #include <avr/pgmspace.h>
 #include <EEPROM.h>
 #include <Morse.h>
+#include <MorseMeter.h>
 #include <MorseEnDecoder.h>  // Morse EnDecoder Library
 #include <SPI.h>
 #include <U8g2lib.h>
-#include <Wire.h>
 
 #define SCREEN_WIDTH 128 // OLED display width, in pixels
 #define SCREEN_HEIGHT 32 // OLED display height, in pixels
 
-U8G2_SSD1306_128X32_UNIVISION_F_HW_I2C lcd(U8G2_R0); 
+#ifdef LCD_FULL_BUFFER
+U8G2_SSD1306_128X32_UNIVISION_F_HW_I2C lcd(U8G2_R0);  // 512 byte frame buffer
+#else
+U8G2_SSD1306_128X32_UNIVISION_1_HW_I2C lcd(U8G2_R0);  // 128 byte page buffer, see lcdRender()
+#endif
+#ifdef U8G2_WITH_GLYPH_CACHE
+uint8_t lcdGlyphCache[160];  // decoded glyphs of the menu font, see U8G2_WITH_GLYPH_CACHE
+#endif
 #define headerText "CW Trainer [ZS6JGP]"
 // These #defines make it easy to set the LCD backlight color
 #define RED 0x1
@@ -68,42 +75,33 @@ char line_buf[20];
 //            KOCH_NUM is number to use
 //            KOCH_SKIP is number to skip
 //    6 = reserved
-#define SAVED_FLG 0     // will be 170 if settings have been saved to EEPROM
+#define SAVED_FLG 0     // will be 171 if settings have been saved to EEPROM (170 before FARNS_WPM)
 #define GROUP_NUM 1     // expected number of cw characters to be received
-#define GROUP_DLY 2     // delay before sending (in 0.01 sec increments)
+#define FARNS_WPM 2     // Farnsworth (overall) speed in WPM, 0 = off
 #define KEY_SPEED 3     // morse keying speed (WPM)
 #define CHAR_SET  4     // defines which character set to send the student.
 #define KOCH_NUM  5     // how many character to use
 #define KOCH_SKIP 6     // characters to skip in the Koch table
-#define OUT_MODE  7     // 0 = Key, 1 = Speaker
-#define NUM_PREFS 8     // number of entries in the preference list
+#define OUT_MODE  7     // 0 = Key, 1 = Speaker, 2 = Sine sidetone, 3 = Key + sidetone
+#define TONE_HZ   8     // sidetone pitch (in 10 Hz increments)
+#define SPEED_CAL 9     // speed trim in 0.1% steps, 100 = none, set by the PARIS test
+#define NUM_PREFS 10    // number of entries in the preference list
 byte prefs[NUM_PREFS];  // Table of preference values
 
-//=========================================
-// There is a document at the ARRL that tells how to measure CW speed by sending PARIS. 
-// The length of time it takes to send PARIS in seconds divided in to 60 gives the speed in WPM
-// with the Key_speed_adj = -2, 
-// and the characters delay = 0, the measured output speed is
-// 20 wpm measured to be 19.9 wpm
-// 25 wpm measured to be 25.3 wpm
-// 30 wpm measured to be 30.8 wpm
-//
-// and the characters delay = 10, the measured output speed is
-// 20 wpm measured to be 17.7 wpm
-// 25 wpm measured to be 21.6 wpm
-// 30 wpm measured to be 25.6 wpm
-//
-// and the characters delay = 20, the measured output speed is
-// 20 wpm measured to be 15.7 wpm
-// 25 wpm measured to be 18.9 wpm
-// 30 wpm measured to be 21.9 wpm
-//=========================================
-int Key_speed_adj = -2; // correction for keying speed
 
 // IO definitions
 const byte morseInPin = 4; // Pin for input
 const byte beep_pin = 6;  // Pin for CW tone
 const byte key_pin = 5;   // Pin for CW Key
+const byte tone_pin = 3;  // Pin for the sine sidetone (Timer2 PWM)
+const byte cal_pin = 13;  // Keyed along in the PARIS test, measured by its pin change interrupt
+
+// The keyer input and cal pins are fixed, so their pin change interrupts
+// read them with a single sbis (MORSE_NO_PCINT_ISR keeps the library's out)
+#if defined(__AVR__) && defined(MORSE_NO_PCINT_ISR)
+ISR(PCINT2_vect) { morseDecoder::captureEdge(FastPin<morseInPin>()); }
+ISR(PCINT0_vect) { morseDecoder::captureEdge(FastPin<cal_pin>()); }
+#endif
 
 // Forward Declared Functions
 byte prefs_set(byte pref, int val);
@@ -112,12 +110,16 @@ void morse_trainer();
 void morse_decode();
 void set_prefs();
 void paris_test();
+void morse_outputs(Morse &morse);
 uint8_t readButtons(void);
 void prefs_init();
+void prefs_save();
 void lcdWrite(const char *s);
 void lcdWrite(const char *s, uint32_t delay);
 void lcdWrite(char *s);
 void lcdWriteHeader(const char *s);
+void lcdDraw(char *s, const char *h);
+boolean lcdStep();
  
 
 //Button Definitions (Required as this was in the Adafruit_RGBLCDShield class
@@ -144,6 +146,13 @@ void setup()
   Serial.println("N4TL CW Trainer");
   
   lcd.begin();
+#ifdef U8G2_WITH_GLYPH_CACHE
+  lcd.setGlyphCache(lcdGlyphCache, sizeof(lcdGlyphCache), u8g2_font_logisoso16_tr);
+#endif
+#ifdef U8G2_WITH_FONT_INDEX
+  lcd.setFontIndex(u8g2_font_5x7_tf);  // the header font, drawn with every screen
+#endif
+  u8x8_SetFont(lcd.getU8x8(), u8x8_font_chroma48medium8_r);  // for the LCD_GLYPHS cells
   //lcdWrite("ZS6JGP", 500);
   //lcdWrite("CW Trainer",500);
   //lcdWrite("de N4TL",500);
@@ -239,66 +248,229 @@ byte get_mode()
 //====================
 // LCD Write 
 //====================
+// The screens below only set what the display should show, lcdRender()
+// draws it. With the page buffer (the default) u8g2 keeps one 128 byte
+// tile row instead of the 512 byte frame, and lcdRender() runs once for
+// each of the 4 rows, drawing only what falls into it. Build with
+// -D LCD_FULL_BUFFER for the full frame buffer, drawn once per frame,
+// and -D U8G2_WITH_DIRTY_TILES so that only the tiles it changed go out.
+//
+// The trainer's characters skip all that: LCD_GLYPHS puts them in cells
+// of 2x2 tiles (16x16 pixel, upscaled 8x8 u8x8 font) and lcdPutChar()
+// writes just the 4 tiles of the cell to the display.
+#define LCD_BODY_Y 12            // first pixel row below the header
+#define LCD_TEXT   0             // body in logisoso16: menus
+#define LCD_LARGE  1             // body in logisoso18, e.g. the decoder
+#define LCD_PREFS  2             // preference name and value
+#define LCD_GLYPHS 3             // body in 2x2 tile cells, one character each
+#define LCD_GLYPH_ROW 2          // tile row of the cells, below the header
+#define LCD_GLYPH_CELLS 8
+
+struct {
+  char header[24];               // empty for none
+  char text[20];                 // LCD_GLYPHS: one character per cell
+  char value[10];                // LCD_PREFS only
+  byte body;
+} lcdScreen;
+boolean lcdChanged = false;      // lcdScreen isn't on the display yet
+boolean lcdPaging = false;       // lcdStep() is part way through a frame
+
+void lcdSet(char *dst, const char *s, size_t n) {
+  strncpy(dst, s ? s : "", n - 1);
+  dst[n - 1] = '\0';
+}
+
+void lcdSetBody(byte body, const char *s, const char *h) {
+#ifdef LCD_FULL_BUFFER
+  if (lcdScreen.body == LCD_GLYPHS && body != LCD_GLYPHS)
+    lcd.setBufferDirty(1);       // the cells aren't in the buffer, send it all
+#endif
+  lcdScreen.body = body;
+  lcdSet(lcdScreen.text, s, sizeof(lcdScreen.text));
+  lcdSet(lcdScreen.header, h, sizeof(lcdScreen.header));
+  lcdChanged = true;
+}
+
+void lcdDrawGlyph(byte cell) {
+  u8x8_Draw2x2Glyph(lcd.getU8x8(), cell * 2, LCD_GLYPH_ROW, lcdScreen.text[cell]);
+}
+
+// Writes the cells over a frame that has just been sent
+void lcdDrawGlyphs() {
+  if (lcdScreen.body != LCD_GLYPHS) return;
+  for (byte i = 0; i < LCD_GLYPH_CELLS; i++)
+    if (lcdScreen.text[i] != ' ') lcdDrawGlyph(i);
+}
+
+// Draws the whole screen from lcdScreen, called once per page
+void lcdRender() {
+  switch (lcdScreen.body) {
+  case LCD_TEXT:
+    lcd.setColorIndex(BLUE);
+    lcd.setFont(u8g2_font_logisoso16_tr);  // choose a suitable font at https://github.com/olikraus/u8g2/wiki/fntlistall
+    lcd.drawStr(0, 32, lcdScreen.text);
+    break;
+  case LCD_LARGE:
+    lcd.setColorIndex(BLUE);
+    lcd.setFont(u8g2_font_logisoso18_tr);
+    lcd.drawStr(0, 32, lcdScreen.text);
+    break;
+  case LCD_PREFS:
+    lcd.setColorIndex(WHITE);
+    lcd.setFont(u8g2_font_t0_12b_mf);
+    lcd.drawStr(0, 20, lcdScreen.text);
+    lcd.setFont(u8g2_font_5x7_tf);
+    lcd.drawStr(0, 30, lcdScreen.value);
+    break;
+  }                              // LCD_GLYPHS: drawn by lcdDrawGlyphs() after the frame
+
+  lcd.setDrawColor(0);           // the header area, over anything the body reached into
+  lcd.drawBox(0, 0, SCREEN_WIDTH, LCD_BODY_Y);
+  if (lcdScreen.header[0]) {
+    lcd.setColorIndex(GREEN);
+    lcd.setFont(u8g2_font_5x7_tf);
+    lcd.drawStr(0, 10, lcdScreen.header);
+  }
+}
+
+// Sends one tile row of the current screen, so the caller can decode
+// between the calls. Returns true while there is more to send. A change
+// part way through starts a new frame, so the display always ends up
+// showing the latest screen.
+boolean lcdStep() {
+#ifdef LCD_FULL_BUFFER
+  if (lcdChanged) {
+    lcdChanged = false;
+    lcdPaging = true;
+    lcd.clearBuffer();
+    lcdRender();
+  }
+  if (lcd.sendBufferStep())
+    return true;
+  if (!lcdPaging)
+    return false;
+#else
+  if (!lcdPaging) {
+    if (!lcdChanged)
+      return false;
+    lcd.firstPage();
+    lcdPaging = true;
+    lcdChanged = false;
+  }
+  lcdRender();
+  if (lcd.nextPage())
+    return true;
+#endif
+  lcdPaging = false;
+  if (lcdChanged)
+    return true;
+  lcdDrawGlyphs();
+  return false;
+}
+
+// Sends the current screen
+void lcdShow() {
+  lcdPaging = false;           // start over with the first row
+  lcdChanged = true;
+  while (lcdStep());
+}
+
 void lcdWrite(const char *s, uint32_t d) {
   lcdWrite(s);
   delay(d);
 }
 
-void lcdWriteMorseIn(const char *s, uint32_t d) {
-  lcd.setColorIndex(BLUE);
-  // lcd.clearBuffer();         // clear the internal memory
-  lcd.setFont(u8g2_font_logisoso16_tr);  // choose a suitable font at https://github.com/olikraus/u8g2/wiki/fntlistall
-  lcd.drawStr(20,32,s);  // write something to the internal memory
-  
-  lcdWriteHeader(headerText);
-  lcd.sendBuffer();         // transfer internal memory to the display
-  delay(d);
+// Shows c in a 2x2 tile cell. The first call sets up the screen, which
+// the caller then sends with lcdStep(), later ones write the 4 tiles of
+// the cell straight to the display.
+void lcdPutChar(byte cell, char c) {
+  if (lcdScreen.body != LCD_GLYPHS) {
+    lcdSetBody(LCD_GLYPHS, "        ", headerText);
+  }
+  lcdScreen.text[cell] = c;
+  if (!lcdChanged && !lcdPaging)
+    lcdDrawGlyph(cell);          // else it goes out with the frame
 }
+
 void lcdWriteHeader(const char *s) {
-  lcd.setColorIndex(GREEN);
-  //lcd.clearBuffer();         // clear the internal memory
-  lcd.setFont(u8g2_font_5x7_tf);  // choose a suitable font at https://github.com/olikraus/u8g2/wiki/fntlistall
-  lcd.drawStr(0, 10, s);  // write something to the internal memory
+  lcdSet(lcdScreen.header, s, sizeof(lcdScreen.header));
+  lcdChanged = true;
 }
 
 void lcdWrite(const char *s) {
-  lcd.setColorIndex(BLUE);
-  lcd.clearBuffer();         // clear the internal memory
-  lcd.setFont(u8g2_font_logisoso16_tr);  // choose a suitable font at https://github.com/olikraus/u8g2/wiki/fntlistall
-  lcd.drawStr(0,32,s);  // write something to the internal memory
-  
-  lcdWriteHeader(headerText);
-  lcd.sendBuffer();         // transfer internal memory to the display
-
+  lcdSetBody(LCD_TEXT, s, headerText);
+  lcdShow();
 }
 
 void lcdWritePrefs(const char *prefItem, const char *prefValue) {
-  lcd.setColorIndex(WHITE);
-  lcd.clearBuffer();         // clear the internal memory
-  lcd.setFont(u8g2_font_t0_12b_mf);  // choose a suitable font at https://github.com/olikraus/u8g2/wiki/fntlistall
-  lcd.drawStr(0,20, prefItem);  // write something to the internal memory
-  lcd.setFont(u8g2_font_5x7_tf);  // choose a suitable font at https://github.com/olikraus/u8g2/wiki/fntlistall
-  lcd.drawStr(0,30, prefValue);  // write something to the internal memory
-
-  lcdWriteHeader(settingsHeader);
-  lcd.sendBuffer();         // transfer internal memory to the display
-
+  lcdSetBody(LCD_PREFS, prefItem, settingsHeader);
+  lcdSet(lcdScreen.value, prefValue, sizeof(lcdScreen.value));
+  lcdShow();
 }
 
 void lcdWrite(char *s) {
-  lcd.clearBuffer();         // clear the internal memory
-  lcd.setFont(u8g2_font_logisoso18_tr);  // choose a suitable font at https://github.com/olikraus/u8g2/wiki/fntlistall
-  lcd.drawStr(0, 32, s);  // write something to the internal memory
-  lcd.sendBuffer();         // transfer internal memory to the display
+  lcdSetBody(LCD_LARGE, s, NULL);
+  lcdShow();
 }
 
+// Sets the screen without sending it, see lcdStep()
+void lcdDraw(char *s, const char *h) {
+  lcdSetBody(LCD_LARGE, s, h);
+}
 
 void lcdWrite(char *s, char* h) {
-  lcd.clearBuffer();         // clear the internal memory
-  lcd.setFont(u8g2_font_logisoso18_tr);  // choose a suitable font at https://github.com/olikraus/u8g2/wiki/fntlistall
-  lcd.drawStr(0, 32, s);  // write something to the internal memory
-  lcdWriteHeader(h);
-  lcd.sendBuffer();         // transfer internal memory to the display
+  lcdDraw(s, h);
+  lcdShow();
+}
+
+// Ticker for the decoder: received characters in 2x2 tile cells, 8 to a
+// line, scrolling up without end. The SSD1306 RAM holds 8 tile rows and
+// shows 4 of them from its start line on, so the next line is written
+// below the visible ones and the start line moves down onto it, one pixel
+// per LCD_SCROLL_MS. Each character also blanks its cell of the line
+// after, which is clear by the time it scrolls in: every character costs
+// the same 8 tiles on the bus and no frame is ever sent.
+#define LCD_SCROLL_MS 10
+byte lcdTickerRow;               // tile row of the line being written, 0..7
+byte lcdTickerCol;               // next cell in it
+byte lcdTickerStart;             // display start line
+unsigned long lcdTickerTime;     // of the last scroll step
+
+void lcdTickerBegin(const char *h) {
+  lcdSetBody(LCD_LARGE, "", h);
+  lcdShow();
+  lcdTickerRow = 2;              // below the header
+  lcdTickerCol = 0;
+  lcdTickerStart = 0;
+}
+
+void lcdTickerPut(char c) {
+  u8x8_t *u8x8 = lcd.getU8x8();
+  if (lcdTickerCol == LCD_GLYPH_CELLS) {  // line full, start the next
+    lcdTickerCol = 0;
+    lcdTickerRow = (lcdTickerRow + 2) & 7;
+  }
+  u8x8_Draw2x2Glyph(u8x8, lcdTickerCol * 2, lcdTickerRow, c);
+  u8x8_Draw2x2Glyph(u8x8, lcdTickerCol * 2, (lcdTickerRow + 2) & 7, ' ');
+  lcdTickerCol++;
+}
+
+// Scrolls a pixel towards the line being written, call it between decodes
+void lcdTickerStep() {
+  byte target = ((lcdTickerRow - 2) & 7) * 8;  // that line at the bottom
+  if (lcdTickerStart == target || millis() - lcdTickerTime < LCD_SCROLL_MS)
+    return;
+  lcdTickerTime = millis();
+  lcdTickerStart = (lcdTickerStart + 1) & 63;
+  u8x8_ssd1306_128x32_SetStartLine(lcd.getU8x8(), lcdTickerStart);
+}
+
+void lcdTickerEnd() {
+  u8x8_ssd1306_128x32_SetStartLine(lcd.getU8x8(), 0);
+#ifdef LCD_FULL_BUFFER
+  lcd.setBufferDirty(1);         // the ticker wrote over the display
+#endif
+  lcdChanged = true;
 }
 //====================
 // Set Preferences menu Function
@@ -308,13 +480,15 @@ void set_prefs()
   // Prefs menu strings
   const static char prf0[] PROGMEM = "Saving";
   const static char prf1[] PROGMEM = "Code Group Size";
-  const static char prf2[] PROGMEM = "Character Delay";
+  const static char prf2[] PROGMEM = "Farnsworth WPM";
   const static char prf3[] PROGMEM = "Code Speed";
   const static char prf4[] PROGMEM = "Character Set";
   const static char prf5[] PROGMEM = "Koch No";
   const static char prf6[] PROGMEM = "Skip Characters";
-  const static char prf7[] PROGMEM = "Out: 0=key,1=spk";
-  const static char* const prefs_menu[] PROGMEM = {prf0, prf1, prf2, prf3, prf4, prf5,prf6,prf7};
+  const static char prf7[] PROGMEM = "Out:k/spk/sin/k+sin";
+  const static char prf8[] PROGMEM = "Tone Pitch x10Hz";
+  const static char prf9[] PROGMEM = "Speed Cal 0.1%";
+  const static char* const prefs_menu[] PROGMEM = {prf0, prf1, prf2, prf3, prf4, prf5,prf6,prf7,prf8,prf9};
 
   byte pref = 1;  // current pref
   int p_val;
@@ -397,10 +571,7 @@ void set_prefs()
   // lcdWrite(line_buf, 500);
  
   // Save all prefs to EEPROM before returning.
-  prefs_set(SAVED_FLG, 170);  // Set prefs saved flag
-  for (int i=0; i<NUM_PREFS; i++) {
-    EEPROM.write(i, prefs[i]);
-  }
+  prefs_save();
 
   lcdWrite("Saved!", 500);
   
@@ -410,6 +581,30 @@ void set_prefs()
 }  // end set_prefs()
 
 
+//====================
+// Morse sender outputs, as set in the preferences. The key pin is fixed,
+// so it is keyed through FastPin; the speaker and sidetone need a timer.
+//====================
+void morse_outputs(Morse &morse)
+{
+  switch (prefs[OUT_MODE]) {
+    case 0:  // Digital (key) output
+      morse.addOutput(FastPin<key_pin>());
+      break;
+    case 1:  // Analog (beep) output
+      morse.addOutput(beep_pin, 1);
+      break;
+    case 2:  // Sine sidetone output
+      morse.addOutput(tone_pin, 2);
+      break;
+    case 3:  // Key and sidetone output
+      morse.addOutput(tone_pin, 2);
+      morse.addOutput(FastPin<key_pin>());
+      break;
+  }
+}
+
+
 //====================
 // Morse code trainer function
 //====================
@@ -431,14 +626,10 @@ void morse_trainer()
 
   // Miscelaneous loop parameters
   byte i,j;
+  byte left;        // characters the sender still has to send
   boolean error = false;
   byte buttons;
 
-  // Morse sender parameters
-  byte _speed;
-  byte _pin;
-  byte _mode;
-  
 
   // Init ===========================================================
   Serial.println("Morse trainer started");
@@ -446,20 +637,14 @@ void morse_trainer()
 
   // Setup Morse receiver
   morseDecoder morseInput = morseDecoder(morseInPin, MORSE_KEYER, MORSE_ACTIVE_LOW);
+  morseInput.beginCapture();  // don't lose key edges while the display is busy
   
   // Setup Morse sender
-  _speed = prefs[KEY_SPEED] + Key_speed_adj;
-  switch (prefs[OUT_MODE]) {
-    case 0:  // Digital (key) output
-      _pin = key_pin;
-      _mode = 0;
-      break;
-    case 1:  // Analog (beep) output
-      _pin = beep_pin;
-      _mode = 1;
-      break;
-  }
-  Morse morse = Morse(_pin, _speed, _mode);  
+  Morse morse(prefs[KEY_SPEED]);
+  morse_outputs(morse);
+  morse.pitch(prefs[TONE_HZ] * 10);
+  morse.farnsworth(prefs[FARNS_WPM]);
+  morse.trim(prefs[SPEED_CAL] - 100);
   
   // Setup character set
   // Note: The high limit on random() is exclusive, so 'hi' is the table index + 1 
@@ -502,29 +687,36 @@ void morse_trainer()
     Serial.print("\nTop of the send loop  ");
     //// lcd.fillScreen(ST7735_BLACK);
 
-    // Send characters to trainee
-    for (i = 0; i < (prefs[GROUP_NUM]); i++)
-    {
-      if (!error) {  // if no error on last round, generate new text.
+    // Pick the characters to send
+    if (!error) {  // if no error on last round, generate new text.
+      for (i = 0; i < (prefs[GROUP_NUM]); i++)
+      {
         j = random(lo, hi);
         cw_tx[i] = ch_buf[j];
       }
+    }
 
-      if (prefs[GROUP_DLY] > 0) {  //Wait out delay between characters
-        delay(prefs[GROUP_DLY] * 10);
-      }
-
-      char cDisplay[3] = "  ";
-      cDisplay[0] = cw_tx[i];
-      cDisplay[1] = '\n';
+    // Send characters to trainee
+    // The sender is timed from Timer1, so updating the display while it
+    // runs doesn't stretch the character spacing.
+    i = 0;     // next character to queue
+    j = 0xff;  // character on the display
+    do
+    {
+      if (i < prefs[GROUP_NUM] && morse.queue(cw_tx[i]))
+        i++;   // Send the character
 
-      char* cPtr = &cw_tx[i];
-      //char* charPtr = &myChar;
+      // Show each character as it goes out
+      left = morse.remaining();
+      if (left && j != i - left) {
+        j = i - left;
 
-      lcdWrite(cDisplay, 10); //cw_tx[i]);  // Display the sent char
-      morse.send(cw_tx[i]);   // Send the character
-      Serial.print(cw_tx[i]); // debug print
-    }
+        lcdPutChar(0, cw_tx[j]);  // Display the sent char
+        lcdPutChar(1, ' ');
+        Serial.print(cw_tx[j]); // debug print
+      }
+      lcdStep();  // the header frame, the characters go out at once
+    } while (i < prefs[GROUP_NUM] || !morse.done());
 
     // Now check the trainee's sending
     Serial.print("\nTop of the check loop ");
@@ -534,18 +726,21 @@ void morse_trainer()
     //morseInput.setspeed(prefs[KEY_SPEED]);
     // Serial.print("Key speed for decoding set to: "); Serial.println(prefs[KEY_SPEED]);
     do {  
-      morseInput.decode();  // Start decoder and check char when it comes in
+      morseInput.decode(FastPin<morseInPin>());  // Start decoder and check char when it comes in
       if (morseInput.available()) {
         char cw_rx = morseInput.read();
         if (cw_rx != ' ') {  // Skip spaces
-          lcdWriteMorseIn(&cw_rx, 500);
+          lcdPutChar(1, cw_rx);  // next to the sent one
           Serial.print(cw_rx);
           if (cw_rx != cw_tx[rx_cnt]) error = true;
           ++rx_cnt;
         }
       }
+      lcdStep();  // update the display one tile row at a time
       if (buttons = readButtons()) break;
     } while (rx_cnt < prefs[GROUP_NUM] && !error);
+    while (lcdStep());
+    delay(500);  // let the trainee see the last character
 
     // Set backlignt according to trainee's performance
     if (error) {
@@ -575,116 +770,123 @@ void morse_decode()
 {
   char cw_rx;
   byte button;
-  byte ch_cnt = 0;
-  char caCwRx[9] = "      \n";
 
   morseDecoder morseInput = morseDecoder(morseInPin, MORSE_KEYER, MORSE_ACTIVE_LOW);
+  morseInput.beginCapture();  // don't lose key edges while the display is busy
 
   Serial.println("Morse decoder started");
-  // // lcd.fillScreen(ST7735_BLACK);
-  //lcd.setCursor(0, 1);
-  // JGP lcd.leftToRight();
-  lcdWrite(" ", decoderHeader);
+  lcdTickerBegin(decoderHeader);
   
   do {
-    morseInput.decode();  // Decode incoming CW
+    morseInput.decode(FastPin<morseInPin>());  // Decode incoming CW
     if (morseInput.available()) {  // If there is a character available
       cw_rx = morseInput.read();  // Read the CW character
-      if (cw_rx != ' ')
-      {
-
-        if (ch_cnt == 8) {
-          for (int i =0; i < 8; i++)
-            caCwRx[i] = ' ';
-          //lcd.setCursor(0,1);
-          //lcdWrite("                ");
-          //lcd.setCursor(0,1);
-          Serial.print('\n');
-          ch_cnt = 0;
-        } 
-        Serial.print(cw_rx); // send character to the debug serial monitor
-        //String cwRxStr(cw_rx);
-      // char* cPtr = &cw_rx;
-        
-        //caCwRx[0] = cw_rx;
-        //caCwRx[1] = '\n';
-        //cwRxStr.toCharArray(caCwRx, cw_rx);
-  
-        //lcdWrite(caCwRx); //cw_rx);  // Display the CW character
-        ++ch_cnt;
-        caCwRx[ch_cnt] = cw_rx;
-        caCwRx[ch_cnt + 1] = '\n';
-        Serial.print(" caCwRx: "); Serial.println(caCwRx);
-        lcdWrite(caCwRx, decoderHeader);
-      }
-    } // if != ' ' / not space
+      Serial.print(cw_rx); // send character to the debug serial monitor
+      lcdTickerPut(cw_rx);  // word spaces too
+    }
+    lcdTickerStep();  // scroll a pixel at a time, between decodes
 
   } while (!(button = readButtons()));
 
+  lcdTickerEnd();
   while (readButtons());
 }  // end of morse_decode()
 
 
 //=====================================
 // "PARIS" test routine
+//
+// Sends PARIS words and measures them: cal_pin is keyed along with the
+// output, and its pin change interrupt timestamps every edge with
+// micros(), so the measurement sees the sender's real key timing. Each
+// word prints the speed, dot and gaps to the serial port and shows the
+// speed on the display. SELECT stops, RIGHT stops and saves the speed
+// correction that brings the measured speed to the one set.
 //=====================================
 void paris_test()
 {
-  char cw_tx[]= "PARIS";
-  char cw_txMsg[] = "               ";
-
-  // Morse sender parameters
-  byte _speed;
-  byte _pin;
-  byte _mode;
+  const char cw_tx[] = "PARIS ";
+  char cw_txMsg[] = "      ";
+  char header[24];
 
   boolean done = false;
+  byte buttons = 0;
+  boolean down;
+  unsigned long t;
+  unsigned int words = 0;
+
+  // Measure the key on cal_pin; the decoder makes it an input, so it comes
+  // before the sender that makes it an output again
+  morseDecoder calInput(cal_pin, MORSE_KEYER, MORSE_ACTIVE_HIGH);
+  MorseMeter meter;
+  meter.begin(prefs[KEY_SPEED], prefs[FARNS_WPM]);
   
   // Setup Morse sender
-  _speed = prefs[KEY_SPEED] + Key_speed_adj;
-  switch (prefs[OUT_MODE]) {
-    case 0:  // Digital (key) output
-      _pin = key_pin;
-      _mode = 0;
-      break;
-    case 1:  // Analog (beep) output
-      _pin = beep_pin;
-      _mode = 1;
-      break;
-  }
-  Morse morse = Morse(_pin, _speed, _mode);  
-
-  // Loop sending until a button is pressed
-  
+  Morse morse(prefs[KEY_SPEED]);
+  morse_outputs(morse);
+  morse.addOutput(FastPin<cal_pin>());
+  morse.pitch(prefs[TONE_HZ] * 10);
+  morse.farnsworth(prefs[FARNS_WPM]);
+  morse.trim(prefs[SPEED_CAL] - 100);
+  if (!calInput.beginCapture())
+    Serial.println("No capture on the cal pin, sending only");
+
+  // Send PARIS words back to back until a button is pressed. The sender
+  // is timed from Timer1, so each word takes 60 s / WPM (the Farnsworth
+  // speed if set) however long the display takes.
+  Serial.print("\nTop of the send loop  ");
+  byte i = 0;        // next character to queue
+  byte shown = 0xff; // character on the display
+  byte left;         // characters the sender still has to send
   do
   {
-    //char fullString[];
-
-    Serial.print("\nTop of the send loop  ");
-    // // lcd.fillScreen(ST7735_BLACK);
-    delay(1000);  // one second between each paris
-    
-    // Send characters 
-    for (int i = 0; i < 5; i++)
-    {
-      if (readButtons()) done = true;  // if button down, this is last loop
-      if (prefs[GROUP_DLY] > 0) {  //Wait out delay between characters
-        delay(prefs[GROUP_DLY] * 10);
-      }
-      //char *p = const_cast<char*>cw_tx[i];
-      //fullString += &cw_tx[i];
-      //msg = cw_tx[i];
-      cw_txMsg[i] = cw_tx[i];
-
-      lcdWrite(cw_txMsg, parisTestHeader);  // Display the sent char
+    left = morse.remaining();
+    if (!done && left < 2 && morse.queue(cw_tx[i])) {  // keep the next character queued
+      if (++i == sizeof(cw_tx) - 1) i = 0;
+      left++;
+    }
+    if (!done && (buttons = readButtons())) done = true;  // finish the character being sent
+
+    // Measure the edges captured so far
+    while (calInput.readEdge(&down, &t))
+      meter.edge(down, t);
+    if (meter.words() != words) {
+      words = meter.words();
+      unsigned long wpm = meter.wpm100();
+      Serial.print("\nPARIS "); Serial.print(wpm / 100); Serial.print('.');
+      Serial.print(wpm / 10 % 10); Serial.print(wpm % 10);
+      Serial.print(" WPM, dot "); Serial.print(meter.dot());
+      Serial.print(" us, char gap "); Serial.print(meter.charGap());
+      Serial.print(" us, word gap "); Serial.print(meter.wordGap());
+      Serial.println(" us");
+      strcpy(header, parisTestHeader " ");
+      dtostrf(wpm / 100.0, 1, 2, header + strlen(header));
+      strcat(header, " WPM");
+      shown = 0xff;      // redraw with it
+    }
 
-      morse.send(cw_tx[i]);   // Send the character
-      // Serial.print(cw_tx[i]); // debug print
+    // Show each character as it goes out
+    byte k = (i + sizeof(cw_tx) - 1 - left) % (sizeof(cw_tx) - 1);
+    if (left && k != shown) {
+      shown = k;
+      if (k == 0) strcpy(cw_txMsg, "      ");
+      cw_txMsg[k] = cw_tx[k];
+      lcdWrite(cw_txMsg, words ? header : (char*)parisTestHeader);  // Display the sent char
     }
-    for (int j = 0; j <= sizeof(cw_tx); j++)
-      cw_txMsg[j] = ' ';
-    //cw_txMsg = "     ";
-  } while (!done);
+  } while (!done || !morse.done());
+
+  // Keep the correction that makes the measured speed right
+  if ((buttons & BUTTON_RIGHT) && words) {
+    int cal = meter.trim(prefs[SPEED_CAL] - 100);
+    Serial.print("Speed correction "); Serial.print(cal); Serial.println(" x0.1%");
+    if (cal >= -MORSE_TIMING_MAX_TRIM && cal <= MORSE_TIMING_MAX_TRIM) {
+      prefs_set(SPEED_CAL, cal + 100);
+      prefs_save();
+      lcdWrite("Saved!", 500);
+    } else {
+      lcdWrite("Out of range", 500);
+    }
+  }
 
   while (readButtons());  //wait for button to be released
 }  // end of paris_test()
@@ -699,24 +901,45 @@ void paris_test()
 void prefs_init()
 {
   // Restore app settings from the EEPROM if the saved
-  // flag value is 170, otherwise init to defaults.
-  if (EEPROM.read(0) == 170)
+  // flag value is 171 (or 170), otherwise init to defaults.
+  byte saved = EEPROM.read(0);
+  if (saved == 171 || saved == 170)
   {
     for (int idx = 0; idx < NUM_PREFS; idx++)
     {
       prefs_set(idx,EEPROM.read(idx));
     }
+    if (saved == 170)                    // slot 2 held the character delay then
+      prefs_set(FARNS_WPM, 0);
+    if (EEPROM.read(TONE_HZ) == 0xFF)    // saved before there was a sidetone
+      prefs_set(TONE_HZ, 70);
+    if (EEPROM.read(SPEED_CAL) == 0xFF)  // saved before there was a speed cal
+      prefs_set(SPEED_CAL, 100);
   }
   else
   {
     prefs_set(SAVED_FLG, 0);  // Prefs not saved
     prefs_set(GROUP_NUM, 1);  // Send/receive groups of 1 char to start
-    prefs_set(GROUP_DLY, 0);  // Send/receive with no delay
+    prefs_set(FARNS_WPM, 0);  // No Farnsworth spacing
     prefs_set(KEY_SPEED, 25); // Send at 25 wpm to start
     prefs_set(CHAR_SET, 5);   // Use Koch order char set
     prefs_set(KOCH_NUM, 5);   // Use first 5 char in Koch set
     prefs_set(KOCH_SKIP, 0);  // Don't skip over any char to start
     prefs_set(OUT_MODE, 1);   // Output to speaker
+    prefs_set(TONE_HZ, 70);   // 700 Hz sidetone
+    prefs_set(SPEED_CAL, 100); // No speed correction
+  }
+}
+
+
+//===========================
+// Save all prefs to EEPROM
+//===========================
+void prefs_save()
+{
+  prefs_set(SAVED_FLG, 171);  // Set prefs saved flag
+  for (int i=0; i<NUM_PREFS; i++) {
+    EEPROM.write(i, prefs[i]);
   }
 }
 
@@ -728,8 +951,8 @@ void prefs_init()
 //========================
 byte prefs_set(byte pref, int val)
 {
-  const byte lo_lim[] {0, 1, 0, 10, 1, 1, 0, 0};  // Table of lower limits of preference values
-  const byte hi_lim[] {170, 15, 30, 30, 6, 40, 39, 1};  // Table of uppper limits of preference values
+  const byte lo_lim[] {0, 1, 0, 10, 1, 1, 0, 0, 40, 0};  // Table of lower limits of preference values
+  const byte hi_lim[] {171, 15, 30, 30, 6, 40, 39, 3, 100, 200};  // Table of uppper limits of preference values
   byte new_val;
   byte indx;
 
@@ -752,8 +975,8 @@ byte prefs_set(byte pref, int val)
     case GROUP_NUM:
       Serial.print("Group size = ");
       break;
-    case GROUP_DLY:
-      Serial.print("Inter-character Delay = ");
+    case FARNS_WPM:
+      Serial.print("Farnsworth WPM = ");
       break; 
     case KEY_SPEED:
       Serial.print("Key speed = ");
@@ -771,6 +994,12 @@ byte prefs_set(byte pref, int val)
     case OUT_MODE:
       Serial.print("Output mode = ");
       break;
+    case TONE_HZ:
+      Serial.print("Tone pitch x10Hz = ");
+      break;
+    case SPEED_CAL:
+      Serial.print("Speed cal x0.1% = ");
+      break;
     default:
       Serial.print("Preference index out of range\n");
       return new_val;
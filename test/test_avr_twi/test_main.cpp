@@ -0,0 +1,224 @@
+/*
+  The AVR TWI driver of U8x8lib (U8x8lib_avr_twi.h) against an emulated
+  TWI unit: the registers below act like the ATmega328's, one bus step
+  per byte time runs from the native timer interrupt, and everything put
+  on the bus is logged, so the tests can check the framing of transfers.
+*/
+
+#include <Arduino.h>
+#include <U8x8lib.h>
+#include <stdio.h>
+#include <unity.h>
+
+// TWCR bits and status codes, as in avr/io.h and util/twi.h
+#define TWINT 7
+#define TWEA  6
+#define TWSTA 5
+#define TWSTO 4
+#define TWWC  3
+#define TWEN  2
+#define TWIE  0
+#define TW_STATUS (TWSR & 0xf8)
+#define TW_START 0x08
+#define TW_REP_START 0x10
+#define TW_MT_SLA_ACK 0x18
+#define TW_MT_SLA_NACK 0x20
+#define TW_MT_DATA_ACK 0x28
+
+static uint8_t SREG = 0x80;  // global interrupt enable only
+#define cli() (SREG &= 0x7f)
+
+static char bus[1024];       // S: start, P: stop, bytes in hex
+static unsigned int busLen;
+static uint8_t twint;        // TWINT flag of the hardware
+static uint8_t action;       // TWCR written with TWINT set: the next bus step
+static uint8_t address;      // the next byte is the address
+static uint8_t nack;         // nobody answers the address
+static uint8_t stuck;        // SDA held low, nothing completes
+
+static void busLog(const char *s)
+{
+  busLen += snprintf(bus + busLen, sizeof(bus) - busLen, "%s", s);
+}
+
+// Writing TWINT clears the flag and starts the next step, TWEN off resets
+struct TwiControl
+{
+  uint8_t v;
+  TwiControl &operator=(uint8_t x)
+  {
+    if (!(x & _BV(TWEN))) {
+      twint = 0;
+      action = 0;
+    } else if (x & _BV(TWINT)) {
+      twint = 0;
+      action = x;
+    }
+    v = x & ~_BV(TWINT);
+    return *this;
+  }
+  operator uint8_t() const { return v | (twint ? _BV(TWINT) : 0); }
+};
+static TwiControl TWCR;
+static uint8_t TWDR, TWSR, TWBR;
+
+#define ISR(vector) static void vector(void)
+#define TWI_vect twi_vect
+#include <U8x8lib_avr_twi.h>
+
+// One byte time of the bus (about 23 us at 400 kHz)
+static void twiStep(void)
+{
+  char b[4];
+  if (action && !stuck) {
+    if (action & _BV(TWSTA)) {
+      busLog("S");
+      TWSR = TW_START;
+      address = 1;
+      twint = 1;
+    } else if (action & _BV(TWSTO)) {
+      busLog(" P");
+      TWCR.v &= ~_BV(TWSTO);
+    } else {
+      snprintf(b, sizeof(b), " %02X", TWDR);
+      busLog(b);
+      TWSR = address ? (nack ? TW_MT_SLA_NACK : TW_MT_SLA_ACK) : TW_MT_DATA_ACK;
+      address = 0;
+      twint = 1;
+    }
+    action = 0;
+  }
+  if (twint && (TWCR.v & _BV(TWIE)) && (SREG & 0x80))
+    twi_vect();
+}
+
+static U8X8_SSD1306_128X32_UNIVISION_HW_I2C oled;
+static u8x8_t *u8x8 = oled.getU8x8();
+
+void setUp(void)
+{
+  busLen = 0;
+  bus[0] = '\0';
+  nack = 0;
+  stuck = 0;
+  u8x8->i2c_address = 0x78;
+  u8x8_avr_twi_init(u8x8);
+  nativeTimer(23, twiStep);
+}
+
+void tearDown(void)
+{
+  nativeTimer(0, 0);
+}
+
+void test_init_sets_400khz(void)
+{
+  TEST_ASSERT_EQUAL(12, TWBR);  // (16 MHz / 400 kHz - 16) / 2
+  TEST_ASSERT_EQUAL(0, TWSR & 3);
+  TEST_ASSERT_EQUAL_HEX8(_BV(TWEN), TWCR);
+}
+
+void test_transfer_framing(void)
+{
+  static const uint8_t data[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+  uint8_t ctrl = 0x00, cmd[2] = {0xAE, 0xD5};
+
+  u8x8_avr_twi_start(u8x8);
+  u8x8_avr_twi_add(1, &ctrl);
+  u8x8_avr_twi_add(2, cmd);        // copied, joins the control byte
+  u8x8_avr_twi_add(8, data);       // sent from where it is
+  u8x8_avr_twi_stop();
+  nativeAdvance(50);  // the STOP goes out after the ISR
+  TEST_ASSERT_EQUAL_STRING("S 78 00 AE D5 01 02 03 04 05 06 07 08 P", bus);
+  TEST_ASSERT_EQUAL(0, u8x8_avr_twi_busy);
+}
+
+// More blocks than segments: the driver waits for the ISR, then reuses them
+void test_more_blocks_than_segments(void)
+{
+  static const uint8_t data[6][5] = {
+    {0x10, 0x11, 0x12, 0x13, 0x14}, {0x20, 0x21, 0x22, 0x23, 0x24},
+    {0x30, 0x31, 0x32, 0x33, 0x34}, {0x40, 0x41, 0x42, 0x43, 0x44},
+    {0x50, 0x51, 0x52, 0x53, 0x54}, {0x60, 0x61, 0x62, 0x63, 0x64}};
+
+  u8x8_avr_twi_start(u8x8);
+  for (int i = 0; i < 6; i++)
+    u8x8_avr_twi_add(5, data[i]);
+  u8x8_avr_twi_stop();
+  nativeAdvance(50);
+  TEST_ASSERT_EQUAL_STRING("S 78 10 11 12 13 14 20 21 22 23 24 30 31 32 33 34 "
+                           "40 41 42 43 44 50 51 52 53 54 60 61 62 63 64 P", bus);
+}
+
+// Out of data the ISR holds the bus with TWINT set until more arrives
+void test_stalled_transfer_resumes(void)
+{
+  uint8_t b[2] = {0x40, 0xFF};
+
+  u8x8_avr_twi_start(u8x8);
+  nativeAdvance(1000);
+  TEST_ASSERT_EQUAL_STRING("S 78", bus);
+  TEST_ASSERT_EQUAL(1, u8x8_avr_twi_stalled);
+  TEST_ASSERT_TRUE(TWCR & _BV(TWINT));
+  u8x8_avr_twi_add(2, b);
+  u8x8_avr_twi_stop();
+  nativeAdvance(50);
+  TEST_ASSERT_EQUAL_STRING("S 78 40 FF P", bus);
+}
+
+void test_nack_drops_transfer(void)
+{
+  uint8_t b[2] = {0x00, 0xAF};
+
+  nack = 1;
+  u8x8_avr_twi_start(u8x8);
+  u8x8_avr_twi_add(2, b);
+  u8x8_avr_twi_stop();
+  nativeAdvance(50);
+  TEST_ASSERT_EQUAL_STRING("S 78 P", bus);
+
+  nack = 0;
+  busLen = 0;
+  u8x8_avr_twi_start(u8x8);
+  u8x8_avr_twi_add(2, b);
+  u8x8_avr_twi_stop();
+  nativeAdvance(50);
+  TEST_ASSERT_EQUAL_STRING("S 78 00 AF P", bus);
+}
+
+// A stuck bus ends in a TWI reset after the timeout, not in a hang
+void test_stuck_bus_times_out(void)
+{
+  uint8_t b[2] = {0x00, 0xAF};
+
+  stuck = 1;
+  unsigned long t = micros();
+  u8x8_avr_twi_start(u8x8);
+  u8x8_avr_twi_add(2, b);
+  u8x8_avr_twi_stop();
+  t = micros() - t;
+  nativeAdvance(50);
+  TEST_ASSERT_GREATER_OR_EQUAL(U8X8_AVR_TWI_TIMEOUT, t);
+  TEST_ASSERT_LESS_THAN(2 * U8X8_AVR_TWI_TIMEOUT, t);
+  TEST_ASSERT_EQUAL(0, u8x8_avr_twi_busy);
+  TEST_ASSERT_EQUAL_HEX8(_BV(TWEN), TWCR);
+
+  stuck = 0;
+  u8x8_avr_twi_start(u8x8);
+  u8x8_avr_twi_add(2, b);
+  u8x8_avr_twi_stop();
+  nativeAdvance(50);
+  TEST_ASSERT_EQUAL_STRING("S 78 00 AF P", bus);
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_init_sets_400khz);
+  RUN_TEST(test_transfer_framing);
+  RUN_TEST(test_more_blocks_than_segments);
+  RUN_TEST(test_stalled_transfer_resumes);
+  RUN_TEST(test_nack_drops_transfer);
+  RUN_TEST(test_stuck_bus_times_out);
+  return UNITY_END();
+}
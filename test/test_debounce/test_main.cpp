@@ -0,0 +1,130 @@
+/*
+  The keyer debounce of morseDecoder on the native build: a reader hook
+  plays PARIS on the keyer pin with contact bounce after every edge, and
+  the polled decode() has to read through it.
+*/
+
+#include <Arduino.h>
+#include <MorseEnDecoder.h>
+#include <unity.h>
+
+#define KEY_PIN 4     // active high here, the reader hook supplies the level
+
+static unsigned long long edges[400];  // us, key down at even indices
+static int edgeCount;
+static unsigned long bounceUs;         // the contact chatters this long after each edge
+
+static int keyer(uint8_t pin, unsigned long us)
+{
+  unsigned long long t = nativeTime();
+  int i = 0;
+  while (i < edgeCount && edges[i] <= t)
+    i++;
+  int level = (i - 1) % 2 == 0 ? HIGH : LOW;
+  if (i > 0 && t - edges[i - 1] < bounceUs) {
+    // chatter: a level that changes every 150 us, the same every run
+    unsigned long k = (t - edges[i - 1]) / 150;
+    if ((k * 2654435761u ^ i * 40503u) >> 13 & 1)
+      level = !level;
+  }
+  return level;
+}
+
+// PARIS words at wpm from 0.5 s on, returns the end of the last one
+static unsigned long long keyParis(int words, int wpm)
+{
+  static const char * const codes[] = {".--.", ".-", ".-.", "..", "..."};
+  unsigned long long unit = 1200000 / wpm;
+  unsigned long long t = nativeTime() + 500000;
+  edgeCount = 0;
+  for (int w = 0; w < words; w++) {
+    for (int c = 0; c < 5; c++) {
+      for (const char *e = codes[c]; *e; e++) {
+        edges[edgeCount++] = t;
+        t += (*e == '-' ? 3 : 1) * unit;
+        edges[edgeCount++] = t;
+        t += unit;
+      }
+      t += 2 * unit;
+    }
+    t += 4 * unit;
+  }
+  return t + 10 * unit;
+}
+
+// Polls decode() every 20 us until end, returns what was decoded
+static const char *run(morseDecoder &d, unsigned long long end)
+{
+  static char out[64];
+  int len = 0;
+  while (nativeTime() < end) {
+    d.decode();
+    while (d.available() && len < (int)sizeof(out) - 1)
+      out[len++] = d.read();
+    nativeAdvance(20);
+  }
+  out[len] = '\0';
+  return out;
+}
+
+void setUp(void)
+{
+  nativeSetPinReader(keyer);
+  edgeCount = 0;
+}
+
+void tearDown(void)
+{
+  nativeSetPinReader(NULL);
+}
+
+// PARIS at wpm, every edge followed by bounce for 1/BOUNCE_DIVISOR of a dot
+#define BOUNCE_DIVISOR 6
+
+static void checkAccuracy(int wpm)
+{
+  bounceUs = 1200000UL / wpm / BOUNCE_DIVISOR;
+  unsigned long long end = keyParis(3, wpm);
+  morseDecoder d(KEY_PIN, MORSE_KEYER, MORSE_ACTIVE_HIGH);
+  d.setspeed(wpm);
+  TEST_ASSERT_EQUAL_STRING("PARIS PARIS PARIS ", run(d, end));
+}
+
+void test_20wpm_with_bounce(void) { checkAccuracy(20); }
+void test_40wpm_with_bounce(void) { checkAccuracy(40); }
+void test_60wpm_with_bounce(void) { checkAccuracy(60); }
+void test_80wpm_with_bounce(void) { checkAccuracy(80); }
+
+void test_25wpm_with_long_bounce(void)
+{
+  bounceUs = 4000;
+  unsigned long long end = keyParis(2, 25);
+  morseDecoder d(KEY_PIN, MORSE_KEYER, MORSE_ACTIVE_HIGH);
+  d.setspeed(25);
+  TEST_ASSERT_EQUAL_STRING("PARIS PARIS ", run(d, end));
+}
+
+// A spike shorter than the debounce window is no dot
+void test_short_spike_is_ignored(void)
+{
+  bounceUs = 0;
+  unsigned long long t = nativeTime() + 100000;
+  edges[0] = t;
+  edges[1] = t + 2000;
+  edgeCount = 2;
+  morseDecoder d(KEY_PIN, MORSE_KEYER, MORSE_ACTIVE_HIGH);
+  d.setspeed(25);
+  TEST_ASSERT_EQUAL_STRING("", run(d, t + 1000000));
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_20wpm_with_bounce);
+  RUN_TEST(test_40wpm_with_bounce);
+  RUN_TEST(test_60wpm_with_bounce);
+  RUN_TEST(test_80wpm_with_bounce);
+  RUN_TEST(test_25wpm_with_long_bounce);
+  RUN_TEST(test_short_spike_is_ignored);
+  return UNITY_END();
+}
@@ -0,0 +1,108 @@
+/*
+  Dirty tile tracking and u8g2_SendBufferStep() on the native build: the
+  Wire stand-in keeps a copy of the SSD1306 RAM and counts the bytes
+  sent, so a test can see what reached the display and at what cost.
+*/
+
+#include <Arduino.h>
+#include <U8g2lib.h>
+#include <Wire.h>
+#include <unity.h>
+
+#ifndef U8G2_WITH_DIRTY_TILES
+#error "the native environment builds with -D U8G2_WITH_DIRTY_TILES"
+#endif
+
+static U8G2_SSD1306_128X32_UNIVISION_F_HW_I2C display(U8G2_R0);
+
+// The display RAM holds what the buffer holds
+static boolean shown(void)
+{
+  uint8_t *buf = display.getBufferPtr();
+  for (int row = 0; row < 4; row++)
+    if (memcmp(Wire.ram[row], buf + row * 128, 128) != 0)
+      return false;
+  return true;
+}
+
+void setUp(void)
+{
+  display.clearBuffer();
+  display.sendBuffer();
+}
+
+void tearDown(void)
+{
+}
+
+void test_unchanged_buffer_sends_nothing(void)
+{
+  unsigned long bytes = Wire.bytes;
+  display.sendDirtyBuffer();
+  TEST_ASSERT_EQUAL(bytes, Wire.bytes);
+}
+
+void test_pixel_sends_its_tile(void)
+{
+  unsigned long bytes = Wire.bytes;
+  display.sendBuffer();
+  unsigned long full = Wire.bytes - bytes;
+
+  display.drawPixel(20, 9);  // tile 2 of tile row 1
+  bytes = Wire.bytes;
+  display.sendDirtyBuffer();
+  TEST_ASSERT_LESS_THAN(full / 16, Wire.bytes - bytes);
+  TEST_ASSERT_EQUAL_HEX8(0x02, Wire.ram[1][20]);
+  TEST_ASSERT_TRUE(shown());
+}
+
+void test_clear_sends_drawn_tiles_only(void)
+{
+  display.drawBox(0, 0, 8, 8);     // tile 0 of tile row 0
+  display.sendDirtyBuffer();
+  TEST_ASSERT_EQUAL_HEX8(0xff, Wire.ram[0][0]);
+
+  unsigned long bytes = Wire.bytes;
+  display.clearBuffer();
+  display.sendDirtyBuffer();
+  TEST_ASSERT_LESS_THAN(40, Wire.bytes - bytes);
+  TEST_ASSERT_TRUE(shown());
+}
+
+void test_step_sends_one_row_per_call(void)
+{
+  display.drawPixel(0, 0);    // tile row 0
+  display.drawPixel(127, 31); // tile row 3
+  TEST_ASSERT_EQUAL(1, display.sendBufferStep());
+  TEST_ASSERT_EQUAL_HEX8(0x01, Wire.ram[0][0]);
+  TEST_ASSERT_EQUAL_HEX8(0x00, Wire.ram[3][127]);
+  TEST_ASSERT_EQUAL(0, display.sendBufferStep());
+  TEST_ASSERT_TRUE(shown());
+  TEST_ASSERT_EQUAL(0, display.sendBufferStep());
+}
+
+// Drawing between the steps marks tiles again, the display ends up right
+void test_step_catches_up_with_drawing(void)
+{
+  display.drawPixel(0, 0);
+  display.drawPixel(0, 31);
+  TEST_ASSERT_EQUAL(1, display.sendBufferStep());  // row 0
+  display.drawPixel(1, 0);                          // row 0 again
+  int steps = 0;
+  while (display.sendBufferStep())
+    TEST_ASSERT_LESS_THAN(4, ++steps);
+  TEST_ASSERT_TRUE(shown());
+}
+
+int main(int argc, char **argv)
+{
+  display.begin();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_unchanged_buffer_sends_nothing);
+  RUN_TEST(test_pixel_sends_its_tile);
+  RUN_TEST(test_clear_sends_drawn_tiles_only);
+  RUN_TEST(test_step_sends_one_row_per_call);
+  RUN_TEST(test_step_catches_up_with_drawing);
+  return UNITY_END();
+}
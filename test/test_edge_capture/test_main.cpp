@@ -0,0 +1,127 @@
+/*
+  Keyer edge capture of morseDecoder in the native build: the pin change
+  interrupt is emulated on digitalWrite() of the keyer pin, so bursts of
+  edges can be queued with no decode() in between.
+*/
+
+#include <Arduino.h>
+#include <MorseEnDecoder.h>
+#include <unity.h>
+
+#define KEY_PIN 4     // active low, like the trainer's keyer input
+
+static void key(boolean down, unsigned long us)
+{
+  digitalWrite(KEY_PIN, down ? LOW : HIGH);
+  nativeAdvance(us);
+}
+
+void setUp(void)
+{
+  digitalWrite(KEY_PIN, HIGH);
+}
+
+void tearDown(void)
+{
+}
+
+// A contact bouncing faster than anything reads the buffer
+void test_burst_is_queued_in_order(void)
+{
+  morseDecoder d(KEY_PIN, MORSE_KEYER, MORSE_ACTIVE_LOW);
+  TEST_ASSERT_TRUE(d.beginCapture());
+
+  unsigned long start = micros();
+  for (int i = 0; i < 20; i++)
+    key(i % 2 == 0, 100);
+
+  boolean down;
+  unsigned long t, last = start;
+  for (int i = 0; i < 20; i++) {
+    TEST_ASSERT_TRUE(d.readEdge(&down, &t));
+    TEST_ASSERT_EQUAL(i % 2 == 0, down);
+    TEST_ASSERT_TRUE(t >= last);
+    last = t;
+  }
+  TEST_ASSERT_FALSE(d.readEdge(&down, &t));
+  TEST_ASSERT_EQUAL(20, d.edgeHighWater);
+  TEST_ASSERT_EQUAL(0, d.edgeOverflows);
+}
+
+// A full buffer drops the newest edges and counts them
+void test_overflow_is_counted(void)
+{
+  morseDecoder d(KEY_PIN, MORSE_KEYER, MORSE_ACTIVE_LOW);
+  TEST_ASSERT_TRUE(d.beginCapture());
+
+  for (int i = 0; i < MORSE_EDGE_BUFFER_SIZE + 9; i++)
+    key(i % 2 == 0, 100);
+
+  boolean down;
+  unsigned long t;
+  int n = 0;
+  while (d.readEdge(&down, &t))
+    n++;
+  TEST_ASSERT_EQUAL(MORSE_EDGE_BUFFER_SIZE - 1, n);
+  TEST_ASSERT_EQUAL(MORSE_EDGE_BUFFER_SIZE - 1, d.edgeHighWater);
+  TEST_ASSERT_EQUAL(10, d.edgeOverflows);
+  digitalWrite(KEY_PIN, HIGH);
+}
+
+// A whole word keyed while the caller is busy still decodes afterwards
+void test_word_decodes_after_busy_time(void)
+{
+  static const char * const paris[] = {".--.", ".-", ".-.", "..", "..."};
+  const unsigned long dot = 60000;  // 20 WPM
+  morseDecoder d(KEY_PIN, MORSE_KEYER, MORSE_ACTIVE_LOW);
+  d.setspeed(20);
+  TEST_ASSERT_TRUE(d.beginCapture());
+
+  for (int c = 0; c < 5; c++) {
+    for (const char *e = paris[c]; *e; e++) {
+      key(true, (*e == '-' ? 3 : 1) * dot);
+      key(false, dot);
+    }
+    nativeAdvance(2 * dot);
+  }
+  nativeAdvance(7 * dot);
+  TEST_ASSERT_EQUAL(0, d.edgeOverflows);
+
+  char text[8];
+  int n = 0;
+  for (int i = 0; i < 10 && n < 7; i++) {
+    d.decode();
+    while (d.available() && n < 7)
+      text[n++] = d.read();
+  }
+  text[n] = '\0';
+  TEST_ASSERT_EQUAL_STRING_LEN("PARIS", text, 5);
+}
+
+// The buffer is shared, only the decoder capturing last reads from it
+void test_second_decoder_takes_over(void)
+{
+  morseDecoder a(KEY_PIN, MORSE_KEYER, MORSE_ACTIVE_LOW);
+  morseDecoder b(KEY_PIN, MORSE_KEYER, MORSE_ACTIVE_LOW);
+  TEST_ASSERT_TRUE(a.beginCapture());
+  key(true, 100);
+  TEST_ASSERT_TRUE(b.beginCapture());
+  key(false, 100);
+
+  boolean down;
+  unsigned long t;
+  TEST_ASSERT_FALSE(a.readEdge(&down, &t));
+  TEST_ASSERT_TRUE(b.readEdge(&down, &t));
+  TEST_ASSERT_FALSE(down);
+  TEST_ASSERT_FALSE(b.readEdge(&down, &t));
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_burst_is_queued_in_order);
+  RUN_TEST(test_overflow_is_counted);
+  RUN_TEST(test_word_decodes_after_busy_time);
+  RUN_TEST(test_second_decoder_takes_over);
+  return UNITY_END();
+}
@@ -0,0 +1,147 @@
+/*
+  The font index (U8G2_WITH_FONT_INDEX) on the native build: glyph lookups
+  through the index must find what the linear search finds, and font
+  switches must leave the index alone.
+*/
+
+#include <Arduino.h>
+#include <U8g2lib.h>
+#include <time.h>
+#include <unity.h>
+
+#ifndef U8G2_WITH_FONT_INDEX
+#error "the native environment builds with -D U8G2_WITH_FONT_INDEX"
+#endif
+
+// u8g2_font.c, not in u8g2.h
+extern "C" const uint8_t *u8g2_font_get_glyph_data(u8g2_t *u8g2, uint16_t encoding);
+
+static U8G2_SSD1306_128X32_UNIVISION_F_HW_I2C display(U8G2_R0);
+static u8g2_t *u8g2 = display.getU8g2();
+
+// The trainer's fonts, see lcdRender() in src/main.cpp
+static const uint8_t * const fonts[] = {
+  u8g2_font_5x7_tf, u8g2_font_logisoso16_tr, u8g2_font_logisoso18_tr,
+  u8g2_font_t0_12b_mf, u8g2_font_logisoso16_tn};
+
+void setUp(void)
+{
+  display.setFontIndex(NULL);
+}
+
+void tearDown(void)
+{
+}
+
+void test_index_finds_every_glyph(void)
+{
+  for (unsigned int f = 0; f < sizeof(fonts) / sizeof(fonts[0]); f++) {
+    const uint8_t *linear[256];
+    display.setFontIndex(NULL);
+    display.setFont(fonts[f]);
+    for (int e = 0; e < 256; e++)
+      linear[e] = u8g2_font_get_glyph_data(u8g2, e);
+
+    display.setFontIndex(fonts[f]);
+    for (int e = 0; e < 256; e++)
+      TEST_ASSERT_TRUE(linear[e] == u8g2_font_get_glyph_data(u8g2, e));
+  }
+}
+
+// A numbers only font has no letters, the index must not invent them
+void test_missing_glyphs_stay_missing(void)
+{
+  display.setFontIndex(u8g2_font_logisoso16_tn);
+  display.setFont(u8g2_font_logisoso16_tn);
+  TEST_ASSERT_NULL(u8g2_font_get_glyph_data(u8g2, 'A'));
+  TEST_ASSERT_NOT_NULL(u8g2_font_get_glyph_data(u8g2, '5'));
+}
+
+// lcdRender() switches fonts on every page, that must not rebuild it
+void test_font_switch_keeps_the_index(void)
+{
+  display.setFontIndex(u8g2_font_5x7_tf);
+  uint16_t k = u8g2->font_index['K' - U8G2_FONT_INDEX_FIRST];
+  TEST_ASSERT_NOT_EQUAL(0, k);
+
+  for (int page = 0; page < 4; page++) {
+    display.setFont(u8g2_font_t0_12b_mf);
+    display.drawStr(0, 20, "Key Speed");
+    display.setFont(u8g2_font_5x7_tf);
+    display.drawStr(0, 10, "CW Trainer");
+  }
+  TEST_ASSERT_TRUE(u8g2->font_index_font == u8g2_font_5x7_tf);
+  TEST_ASSERT_EQUAL(k, u8g2->font_index['K' - U8G2_FONT_INDEX_FIRST]);
+
+  // and other fonts are still searched, not read from the wrong index
+  display.setFont(u8g2_font_t0_12b_mf);
+  display.setFontIndex(NULL);
+  const uint8_t *linear = u8g2_font_get_glyph_data(u8g2, 'K');
+  display.setFontIndex(u8g2_font_5x7_tf);
+  TEST_ASSERT_TRUE(linear == u8g2_font_get_glyph_data(u8g2, 'K'));
+}
+
+void test_same_pixels_with_the_index(void)
+{
+  static uint8_t linear[512];
+  display.setFont(u8g2_font_5x7_tf);
+  display.clearBuffer();
+  display.drawStr(0, 10, "CW Trainer [ZS6JGP] ~!");
+  memcpy(linear, display.getBufferPtr(), sizeof(linear));
+
+  display.setFontIndex(u8g2_font_5x7_tf);
+  display.clearBuffer();
+  display.drawStr(0, 10, "CW Trainer [ZS6JGP] ~!");
+  TEST_ASSERT_EQUAL_MEMORY(linear, display.getBufferPtr(), sizeof(linear));
+}
+
+// Host time per lookup, best of 5 runs
+static double nsPerLookup(const char *chars)
+{
+  int n = strlen(chars);
+  uintptr_t sum = 0;
+  double best = 1e30;
+  for (int run = 0; run < 5; run++) {
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < 20000; i++)
+      for (int c = 0; c < n; c++)
+        sum += (uintptr_t)u8g2_font_get_glyph_data(u8g2, chars[c]);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double ns = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / (20000.0 * n);
+    if (ns < best) best = ns;
+  }
+  TEST_ASSERT_NOT_EQUAL(0, sum);
+  return best;
+}
+
+// Lookup cost of late alphabet letters and punctuation, the worst case of
+// the linear search, with and without the index. Host time, the AVR
+// would need the same count on the board.
+void test_benchmark(void)
+{
+  static const char * const sets[] = {"XYZxyz", "?/.,~}"};
+  display.setFont(u8g2_font_5x7_tf);
+  for (unsigned int i = 0; i < sizeof(sets) / sizeof(sets[0]); i++) {
+    display.setFontIndex(NULL);
+    double linear = nsPerLookup(sets[i]);
+    display.setFontIndex(u8g2_font_5x7_tf);
+    double indexed = nsPerLookup(sets[i]);
+    char msg[100];
+    snprintf(msg, sizeof(msg), "5x7 \"%s\": linear %.1f ns, indexed %.1f ns, %.1fx",
+             sets[i], linear, indexed, linear / indexed);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_LESS_THAN(linear, indexed);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_index_finds_every_glyph);
+  RUN_TEST(test_missing_glyphs_stay_missing);
+  RUN_TEST(test_font_switch_keeps_the_index);
+  RUN_TEST(test_same_pixels_with_the_index);
+  RUN_TEST(test_benchmark);
+  return UNITY_END();
+}
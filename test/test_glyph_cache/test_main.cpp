@@ -0,0 +1,145 @@
+/*
+  The glyph cache (U8G2_WITH_GLYPH_CACHE) on the native build: text drawn
+  from the cache must set the same pixels as text decoded from the font.
+*/
+
+#include <Arduino.h>
+#include <U8g2lib.h>
+#include <time.h>
+#include <unity.h>
+
+#ifndef U8G2_WITH_GLYPH_CACHE
+#error "the native environment builds with -D U8G2_WITH_GLYPH_CACHE"
+#endif
+
+static U8G2_SSD1306_128X32_UNIVISION_F_HW_I2C display(U8G2_R0);
+static uint8_t cache[160];  // as in src/main.cpp
+static uint8_t decoded[512];
+
+#define TRAINER_CHARS "KMRSUAPTLOWI.NJEF0YV,G5/Q9ZH38B?4271C6DX"
+
+// Draws s at x, y without the cache, then with it, and compares
+static void check(const char *s, int x, int y, uint8_t color, const uint8_t *font)
+{
+  display.setGlyphCache(NULL, 0, NULL);
+  display.clearBuffer();
+  display.setDrawColor(color);
+  display.setFont(font);
+  display.drawStr(x, y, s);
+  memcpy(decoded, display.getBufferPtr(), sizeof(decoded));
+
+  display.setGlyphCache(cache, sizeof(cache), u8g2_font_logisoso16_tr);
+  display.clearBuffer();
+  display.setFont(font);
+  display.drawStr(x, y, s);
+  TEST_ASSERT_EQUAL_MEMORY_MESSAGE(decoded, display.getBufferPtr(), sizeof(decoded), s);
+}
+
+void setUp(void)
+{
+  display.setFontMode(0);
+}
+
+void tearDown(void)
+{
+  display.setGlyphCache(NULL, 0, NULL);
+  display.setDrawColor(1);
+}
+
+void test_same_pixels_as_the_font(void)
+{
+  for (const char *s = TRAINER_CHARS; *s; s += 6) {
+    char part[7];
+    strncpy(part, s, 6);
+    part[6] = '\0';
+    check(part, 0, 32, 1, u8g2_font_logisoso16_tr);
+  }
+}
+
+// Glyphs that don't start on a tile row or are clipped at the edges
+void test_unaligned_and_clipped(void)
+{
+  static const int pos[][2] = {{3, 27}, {1, 20}, {-5, 17}, {110, 31}, {60, 40}, {0, 9}};
+  for (unsigned int i = 0; i < sizeof(pos) / sizeof(pos[0]); i++)
+    check("KMQ?", pos[i][0], pos[i][1], 1, u8g2_font_logisoso16_tr);
+}
+
+void test_draw_colors(void)
+{
+  check("AP5", 2, 30, 0, u8g2_font_logisoso16_tr);
+  check("AP5", 2, 30, 2, u8g2_font_logisoso16_tr);
+  display.setFontMode(1);
+  check("AP5", 2, 30, 1, u8g2_font_logisoso16_tr);
+}
+
+void test_glyphs_are_kept(void)
+{
+  u8g2_t *u8g2 = display.getU8g2();
+  check("K", 0, 32, 1, u8g2_font_logisoso16_tr);
+  uint16_t used = u8g2->glyph_cache_used;
+  TEST_ASSERT_GREATER_THAN(0, used);
+  display.drawStr(20, 32, "K");  // found, not added again
+  TEST_ASSERT_EQUAL(used, u8g2->glyph_cache_used);
+}
+
+// Other fonts are decoded as before and leave the cache alone
+void test_other_font_bypasses_the_cache(void)
+{
+  u8g2_t *u8g2 = display.getU8g2();
+  check("Top", 0, 10, 1, u8g2_font_5x7_tf);
+  TEST_ASSERT_EQUAL(0, u8g2->glyph_cache_used);
+}
+
+// A cache smaller than the text starts over and still draws right
+void test_full_cache_starts_over(void)
+{
+  u8g2_t *u8g2 = display.getU8g2();
+  check("MWQ0", 0, 32, 1, u8g2_font_logisoso16_tr);
+  TEST_ASSERT_LESS_OR_EQUAL(sizeof(cache), u8g2->glyph_cache_used);
+  check("0QWM", 4, 30, 1, u8g2_font_logisoso16_tr);
+}
+
+// Host time per glyph drawn into the buffer, best of 5 runs
+static double nsPerGlyph(boolean cached)
+{
+  display.setGlyphCache(cached ? cache : NULL, sizeof(cache), u8g2_font_logisoso16_tr);
+  display.setFont(u8g2_font_logisoso16_tr);
+  double best = 1e30;
+  for (int run = 0; run < 5; run++) {
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < 2000; i++)
+      display.drawStr(0, 32, "Decoder");  // fits the cache, like a menu screen
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double ns = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / (2000 * 7);
+    if (ns < best) best = ns;
+  }
+  return best;
+}
+
+// Cost per glyph with and without the cache. Host time, the AVR would
+// need the same count on the board.
+void test_benchmark(void)
+{
+  display.clearBuffer();
+  double decoded = nsPerGlyph(false);
+  double cached = nsPerGlyph(true);
+  char msg[100];
+  snprintf(msg, sizeof(msg), "logisoso16 glyph: decoded %.0f ns, cached %.0f ns, %.1fx",
+           decoded, cached, decoded / cached);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_LESS_THAN(decoded, cached);
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_same_pixels_as_the_font);
+  RUN_TEST(test_unaligned_and_clipped);
+  RUN_TEST(test_draw_colors);
+  RUN_TEST(test_glyphs_are_kept);
+  RUN_TEST(test_other_font_bypasses_the_cache);
+  RUN_TEST(test_full_cache_starts_over);
+  RUN_TEST(test_benchmark);
+  return UNITY_END();
+}
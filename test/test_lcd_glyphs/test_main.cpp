@@ -0,0 +1,139 @@
+/*
+  The trainer's characters on the display, native build: the Wire
+  stand-in counts the bytes sent to the SSD1306 and the bus time they
+  take on the virtual clock. Compares the old path, a whole frame drawn
+  with lcdWrite() for every character, with lcdPutChar() writing the 4
+  tiles of a LCD_GLYPHS cell.
+*/
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <unity.h>
+
+void setup();
+void lcdWrite(const char *s);
+void lcdPutChar(byte cell, char c);
+boolean lcdStep();
+
+static const char sent[] = "PARIS0?/KM";
+
+struct cost {
+  unsigned long bytes;
+  unsigned long transfers;
+  unsigned long long us;       // virtual, the bus time at the clock u8x8 set
+};
+
+static unsigned long bytes0, transfers0;
+static unsigned long long us0;
+
+static void costStart(void)
+{
+  bytes0 = Wire.bytes;
+  transfers0 = Wire.transfers;
+  us0 = nativeTime();
+}
+
+// Per character, over n characters
+static cost costEnd(int n)
+{
+  cost c;
+  c.bytes = (Wire.bytes - bytes0) / n;
+  c.transfers = (Wire.transfers - transfers0) / n;
+  c.us = (nativeTime() - us0) / n;
+  return c;
+}
+
+static void report(const char *what, cost c)
+{
+  char msg[120];
+  snprintf(msg, sizeof(msg), "%-34s %4lu bytes in %2lu transfers, %5llu us",
+           what, c.bytes, c.transfers, c.us);
+  TEST_MESSAGE(msg);
+}
+
+static void quiet(uint8_t c)
+{
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+// A cell holds the glyph: something lit in both of its tile rows, and
+// nothing in the cell next to it
+void test_cell_is_drawn(void)
+{
+  lcdPutChar(0, ' ');
+  while (lcdStep());
+  lcdPutChar(1, 'K');
+  boolean top = false, bottom = false;
+  for (int x = 16; x < 32; x++) {
+    top |= Wire.ram[2][x] != 0;
+    bottom |= Wire.ram[3][x] != 0;
+  }
+  TEST_ASSERT_TRUE(top);
+  TEST_ASSERT_TRUE(bottom);
+  for (int x = 32; x < 48; x++)
+    TEST_ASSERT_EQUAL_HEX8(0, Wire.ram[2][x] | Wire.ram[3][x]);
+}
+
+// I2C bytes per trainer character. The old send loop drew every sent
+// character as a frame with lcdWrite(), and every received one as
+// another frame with it next to the sent one; the received frame cost
+// the same as the sent one, so one lcdWrite() stands for each.
+void test_bytes_per_character(void)
+{
+  int n = sizeof(sent) - 1;
+  char s[3] = " \n";
+
+  costStart();
+  for (int i = 0; i < n; i++) {
+    s[0] = sent[i];
+    lcdWrite((const char *)s);
+  }
+  cost frame = costEnd(n);
+
+  // The screen is set up once per round, not per character
+  lcdPutChar(0, ' ');
+  while (lcdStep());
+
+  costStart();
+  for (int i = 0; i < n; i++) {
+    lcdPutChar(0, sent[i]);
+    lcdPutChar(1, ' ');
+  }
+  cost glyphSent = costEnd(n);
+
+  costStart();
+  for (int i = 0; i < n; i++)
+    lcdPutChar(1, sent[i]);
+  cost glyphReceived = costEnd(n);
+
+  report("lcdWrite() frame, sent/received:", frame);
+  report("lcdPutChar(), sent + clear cell:", glyphSent);
+  report("lcdPutChar(), received:", glyphReceived);
+
+  char msg[100];
+  snprintf(msg, sizeof(msg), "a character sent and received back: %lu bytes before, %lu now",
+           2 * frame.bytes, glyphSent.bytes + glyphReceived.bytes);
+  TEST_MESSAGE(msg);
+
+  TEST_ASSERT_EQUAL(2 * glyphReceived.bytes, glyphSent.bytes);
+  TEST_ASSERT_LESS_THAN(frame.bytes / 4, glyphSent.bytes);
+  TEST_ASSERT_LESS_THAN(frame.us / 4, glyphSent.us);
+}
+
+int main(int argc, char **argv)
+{
+  nativeSetSerialWriter(quiet);
+  setup();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_cell_is_drawn);
+  RUN_TEST(test_bytes_per_character);
+  return UNITY_END();
+}
@@ -0,0 +1,118 @@
+/*
+  morseEngine on its own, fed (level, duration) elements: the key timing
+  comes from MorseTiming, so this is also a round trip through the
+  sender's text to timing compiler and back.
+*/
+
+#include <Arduino.h>
+#include <MorseEngine.h>
+#include <MorseTiming.h>
+#include <unity.h>
+
+static char text[80];
+
+// Keys s into e with the sender's timing, then reads what was decoded
+static const char *roundTrip(morseEngine &e, const char *s, byte wpm, byte effectiveWpm)
+{
+  MorseTiming timing;
+  uint16_t prog[400];
+  unsigned int len = 0;
+
+  timing.setSpeed(wpm, effectiveWpm);
+  int n = timing.compile(s, prog, sizeof(prog) / sizeof(prog[0]));
+  TEST_ASSERT_GREATER_THAN(0, n);
+  for (int i = 0; i < n; i++) {
+    e.element(prog[i] & MORSE_TIMING_MARK, MorseTiming::duration(prog[i]));
+    while (e.available() && len < sizeof(text) - 1)
+      text[len++] = e.read();
+  }
+  e.element(false, 10 * 1200000L / wpm);  // let the last word end
+  while (e.available() && len < sizeof(text) - 1)
+    text[len++] = e.read();
+  text[len] = '\0';
+  return text;
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_round_trip(void)
+{
+  morseEngine e;
+  e.setspeed(20);
+  TEST_ASSERT_EQUAL_STRING("CQ DE ZS6JGP 73 ", roundTrip(e, "CQ DE ZS6JGP 73 ", 20, 0));
+}
+
+// Farnsworth gaps are longer than a word space at the character speed,
+// so only the characters come back, each followed by a space
+void test_round_trip_farnsworth(void)
+{
+  morseEngine e;
+  e.setspeed(25);
+  TEST_ASSERT_EQUAL_STRING("P A R I S P A R I S ", roundTrip(e, "PARIS PARIS ", 25, 12));
+  TEST_ASSERT_EQUAL(25, e.getspeed());
+}
+
+void test_round_trip_all_characters(void)
+{
+  morseEngine e;
+  e.setspeed(30);
+  TEST_ASSERT_EQUAL_STRING("0123456789 ABCDEFGHIJKLM NOPQRSTUVWXYZ ,./? ",
+    roundTrip(e, "0123456789 ABCDEFGHIJKLM NOPQRSTUVWXYZ ,./? ", 30, 0));
+}
+
+// signal() and update() on a timeline decode the same as element()
+void test_signal_timeline(void)
+{
+  morseEngine e;
+  const long dot = 60000;  // 20 WPM
+  e.setspeed(20);
+  e.signal(true, 0);              // A: .-
+  e.signal(false, dot);
+  e.signal(true, 2 * dot);
+  e.signal(false, 5 * dot);
+  e.update(7 * dot);              // a char gap
+  TEST_ASSERT_TRUE(e.available());
+  long t;
+  TEST_ASSERT_EQUAL_CHAR('A', e.read(&t));
+  TEST_ASSERT_GREATER_OR_EQUAL(5 * dot, t);
+  TEST_ASSERT_LESS_OR_EQUAL(7 * dot, t);
+  e.update(20 * dot);             // a word gap
+  TEST_ASSERT_EQUAL_CHAR(' ', e.read());
+  TEST_ASSERT_FALSE(e.available());
+}
+
+// Characters nobody reads are counted once the output buffer is full
+void test_full_output_drops_characters(void)
+{
+  morseEngine e;
+  e.setspeed(20);
+  for (int i = 0; i < MORSE_OUTPUT_BUFFER_SIZE + 2; i++) {
+    e.element(true, 60000);      // E
+    e.element(false, 180000);
+  }
+  TEST_ASSERT_TRUE(e.outputFull());
+  TEST_ASSERT_EQUAL(3, e.droppedChars);
+  int n = 0;
+  while (e.available()) {
+    TEST_ASSERT_EQUAL_CHAR('E', e.read());
+    n++;
+  }
+  TEST_ASSERT_EQUAL(MORSE_OUTPUT_BUFFER_SIZE - 1, n);
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_round_trip);
+  RUN_TEST(test_round_trip_farnsworth);
+  RUN_TEST(test_round_trip_all_characters);
+  RUN_TEST(test_signal_timeline);
+  RUN_TEST(test_full_output_drops_characters);
+  return UNITY_END();
+}
@@ -0,0 +1,140 @@
+/*
+  Runs the trainer's menus in the native build: keys are typed on the
+  Serial input at set virtual times, each menu runs for a bounded time
+  and the test checks what it printed.
+*/
+
+#include <Arduino.h>
+#include <signal.h>
+#include <unistd.h>
+#include <unity.h>
+
+void setup();
+void loop();
+
+static char out[4096];        // Serial output of the current test
+static unsigned int outLen;
+
+static void capture(uint8_t c)
+{
+  if (outLen < sizeof(out) - 1)
+    out[outLen++] = c;
+  out[outLen] = '\0';
+}
+
+// A menu that doesn't return in time is a failure, not a hung test run
+static void timeout(int)
+{
+  static const char msg[] = "\ntimed out, the virtual clock stopped\n";
+  write(2, msg, sizeof(msg) - 1);
+  write(2, out, outLen);
+  _exit(1);
+}
+
+// Keyer on morseInPin (4, active low): "PARIS PARIS" at 20 WPM from keyStart
+#define KEY_DOT 60UL  // ms
+static const char * const keyed[] = {".--.", ".-", ".-.", "..", "...", 0,
+                                     ".--.", ".-", ".-.", "..", "...", 0};
+static unsigned long keyStart;  // ms
+static unsigned long keyMarks[2 * 40];  // start and end of each mark, ms from keyStart
+static unsigned int keyCount;
+
+static unsigned long keyDuration()
+{
+  unsigned long t = 0;
+  keyCount = 0;
+  for (unsigned int c = 0; c < sizeof(keyed) / sizeof(keyed[0]); c++) {
+    if (!keyed[c]) {
+      t += 4 * KEY_DOT;  // word gap, after the char gap
+      continue;
+    }
+    for (const char *e = keyed[c]; *e; e++) {
+      keyMarks[keyCount++] = t;
+      t += (*e == '-' ? 3 : 1) * KEY_DOT;
+      keyMarks[keyCount++] = t;
+      t += KEY_DOT;
+    }
+    t += 2 * KEY_DOT;  // char gap
+  }
+  return t;
+}
+
+static int keyer(uint8_t pin, unsigned long us)
+{
+  if (pin != 4) return HIGH;
+  unsigned long ms = us / 1000;
+  if (ms < keyStart) return HIGH;
+  ms -= keyStart;
+  for (unsigned int i = 0; i < keyCount; i += 2)
+    if (ms >= keyMarks[i] && ms < keyMarks[i + 1])
+      return LOW;
+  return HIGH;
+}
+
+void setUp(void)
+{
+  outLen = 0;
+  out[0] = '\0';
+  alarm(10);
+}
+
+void tearDown(void)
+{
+  alarm(0);
+  nativeSetPinReader(NULL);
+}
+
+void test_decoder_menu(void)
+{
+  unsigned long t = millis();
+
+  nativeSetPinReader(keyer);  // before the decoder starts polling the pin
+  keyStart = t + 3000;
+  unsigned long len = keyDuration();
+  Serial.inject("s ", t + 1500);                // DOWN to "Decoder", SELECT
+  Serial.inject(" ", keyStart + len + 2000);    // SELECT stops it
+  loop();
+
+  TEST_ASSERT_NOT_NULL(strstr(out, "Morse decoder started"));
+  TEST_ASSERT_NOT_NULL_MESSAGE(strstr(out, "PARIS"), out);
+  TEST_ASSERT_LESS_THAN(keyStart + len + 3000, millis());
+}
+
+void test_trainer_menu(void)
+{
+  unsigned long t = millis();
+
+  Serial.inject(" ", t + 1500);     // SELECT "Start"
+  Serial.inject(" ", t + 5000);     // one character at 25 WPM, then SELECT
+  loop();
+
+  TEST_ASSERT_NOT_NULL(strstr(out, "Morse trainer started"));
+  TEST_ASSERT_NOT_NULL_MESSAGE(strstr(out, "\nTop of the check loop "), out);
+  TEST_ASSERT_LESS_THAN(t + 7000, millis());
+}
+
+void test_paris_menu(void)
+{
+  unsigned long t = millis();
+
+  Serial.inject("sss ", t + 1500);   // DOWN 3 times to "PARIS Test", SELECT
+  Serial.inject(" ", t + 12000);     // 4 words at 25 WPM, then SELECT
+  loop();
+
+  TEST_ASSERT_NOT_NULL(strstr(out, "\nPARIS 25.00 WPM, dot 48000 us"));
+  TEST_ASSERT_NULL(strstr(out, "Saved!"));
+  TEST_ASSERT_LESS_THAN(t + 14000, millis());
+}
+
+int main(int argc, char **argv)
+{
+  signal(SIGALRM, timeout);
+  nativeSetSerialWriter(capture);
+  setup();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_trainer_menu);
+  RUN_TEST(test_decoder_menu);
+  RUN_TEST(test_paris_menu);
+  return UNITY_END();
+}
@@ -0,0 +1,87 @@
+/*
+  The trainer's preferences on the native build: prefs_init() reads what
+  an older firmware left in the (RAM) EEPROM and fills in the settings
+  that firmware didn't have.
+*/
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <unity.h>
+
+// From src/main.cpp
+#define SAVED_FLG 0
+#define GROUP_NUM 1
+#define FARNS_WPM 2
+#define KEY_SPEED 3
+#define OUT_MODE  7
+#define TONE_HZ   8
+#define SPEED_CAL 9
+extern byte prefs[];
+void prefs_init();
+void prefs_save();
+
+void setUp(void)
+{
+  memset(EEPROM.cells, 0xFF, sizeof(EEPROM.cells));
+  memset(prefs, 0, 10);
+}
+
+void tearDown(void)
+{
+}
+
+// EEPROM as the firmware before the sidetone and the speed cal saved it,
+// slot 2 was the delay between characters in 10 ms steps then
+static void saveOld()
+{
+  const byte old[] = {170, 3, 15, 18, 5, 12, 2, 1};
+  for (unsigned int i = 0; i < sizeof(old); i++)
+    EEPROM.write(i, old[i]);
+}
+
+void test_defaults_when_never_saved(void)
+{
+  prefs_init();
+  TEST_ASSERT_EQUAL(0, prefs[SAVED_FLG]);
+  TEST_ASSERT_EQUAL(25, prefs[KEY_SPEED]);
+  TEST_ASSERT_EQUAL(70, prefs[TONE_HZ]);
+  TEST_ASSERT_EQUAL(100, prefs[SPEED_CAL]);
+}
+
+void test_old_save_gets_the_new_defaults(void)
+{
+  saveOld();
+  prefs_init();
+  TEST_ASSERT_EQUAL(3, prefs[GROUP_NUM]);
+  TEST_ASSERT_EQUAL(0, prefs[FARNS_WPM]);
+  TEST_ASSERT_EQUAL(18, prefs[KEY_SPEED]);
+  TEST_ASSERT_EQUAL(1, prefs[OUT_MODE]);
+  TEST_ASSERT_EQUAL(70, prefs[TONE_HZ]);
+  TEST_ASSERT_EQUAL(100, prefs[SPEED_CAL]);
+}
+
+void test_saved_settings_are_kept(void)
+{
+  saveOld();
+  prefs_init();
+  prefs[FARNS_WPM] = 12;
+  prefs[TONE_HZ] = 55;
+  prefs[SPEED_CAL] = 120;
+  prefs_save();
+  memset(prefs, 0, 10);
+  prefs_init();
+  TEST_ASSERT_EQUAL(171, prefs[SAVED_FLG]);
+  TEST_ASSERT_EQUAL(12, prefs[FARNS_WPM]);
+  TEST_ASSERT_EQUAL(18, prefs[KEY_SPEED]);
+  TEST_ASSERT_EQUAL(55, prefs[TONE_HZ]);
+  TEST_ASSERT_EQUAL(120, prefs[SPEED_CAL]);
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_defaults_when_never_saved);
+  RUN_TEST(test_old_save_gets_the_new_defaults);
+  RUN_TEST(test_saved_settings_are_kept);
+  return UNITY_END();
+}
@@ -0,0 +1,148 @@
+/*
+  The sine sidetone on the native build: Sidetone::tick() is the sample
+  the Timer2 overflow interrupt would write to the PWM compare register,
+  so the tests call it once per sample and look at the waveform.
+*/
+
+#include <Arduino.h>
+#include <Sidetone.h>
+#include <Morse.h>
+#include <unity.h>
+
+#define PIN 3
+#define RAMP_SAMPLES (SIDETONE_RATE * SIDETONE_RAMP_MS / 1000)  // 156
+
+void setUp(void)
+{
+  Sidetone::begin(PIN, 700);
+}
+
+void tearDown(void)
+{
+  Sidetone::end();
+}
+
+// Largest distance from the mid level over n samples
+static int peak(unsigned long n)
+{
+  int p = 0;
+  while (n--) {
+    int d = abs((int)Sidetone::tick() - 128);
+    if (d > p) p = d;
+  }
+  return p;
+}
+
+// Rising crossings of the mid level in one second, after the attack
+static unsigned int measureHz()
+{
+  for (unsigned int i = 0; i < 2 * RAMP_SAMPLES; i++)
+    Sidetone::tick();
+  unsigned int count = 0;
+  byte last = Sidetone::tick();
+  for (unsigned long i = 0; i < SIDETONE_RATE; i++) {
+    byte s = Sidetone::tick();
+    if (last < 128 && s >= 128)
+      count++;
+    last = s;
+  }
+  return count;
+}
+
+void test_pitch(void)
+{
+  Sidetone::key(true);
+  TEST_ASSERT_UINT_WITHIN(1, 700, measureHz());
+  Sidetone::pitch(440);
+  TEST_ASSERT_UINT_WITHIN(1, 440, measureHz());
+}
+
+void test_pitch_is_clamped(void)
+{
+  Sidetone::pitch(100);
+  Sidetone::key(true);
+  TEST_ASSERT_UINT_WITHIN(1, SIDETONE_MIN_HZ, measureHz());
+  Sidetone::pitch(5000);
+  TEST_ASSERT_UINT_WITHIN(1, SIDETONE_MAX_HZ, measureHz());
+}
+
+// The attack follows the raised cosine: no step at key down, a quarter
+// of the way up after a quarter of the ramp, full amplitude after it
+void test_attack_is_ramped(void)
+{
+  Sidetone::key(true);
+  TEST_ASSERT_TRUE(Sidetone::sounding());
+  TEST_ASSERT_LESS_OR_EQUAL(1, peak(RAMP_SAMPLES / 16));
+  int quarter = peak(RAMP_SAMPLES / 4 - RAMP_SAMPLES / 16);
+  TEST_ASSERT_INT_WITHIN(12, 127 * 15 / 100, quarter);  // (1 - cos 45) / 2 of full
+  peak(RAMP_SAMPLES);
+  TEST_ASSERT_INT_WITHIN(1, 127, peak(SIDETONE_RATE / 100));
+}
+
+// No sample to sample step bigger than a full amplitude sine makes on
+// its own, through key down and key up. At the lowest pitch, where the
+// sine itself moves least
+void test_keying_has_no_steps(void)
+{
+  const int limit = 127 * 2 * 314 * SIDETONE_MIN_HZ / 100 / SIDETONE_RATE + 4;  // 127 * 2 pi f / rate, and the table steps
+  Sidetone::pitch(SIDETONE_MIN_HZ);
+  int last = 128, worst = 0;
+  for (int dit = 0; dit < 8; dit++) {
+    Sidetone::key(dit % 2 == 0);
+    for (unsigned int i = 0; i < 3 * RAMP_SAMPLES; i++) {
+      int s = Sidetone::tick();
+      if (abs(s - last) > worst) worst = abs(s - last);
+      last = s;
+    }
+  }
+  TEST_ASSERT_LESS_OR_EQUAL(limit, worst);
+}
+
+// After key up the tone ramps down and stops within the ramp time, then
+// rests at the mid level with the interrupt off
+void test_release_goes_silent(void)
+{
+  Sidetone::key(true);
+  peak(3 * RAMP_SAMPLES);
+  Sidetone::key(false);
+  TEST_ASSERT_GREATER_THAN(100, peak(RAMP_SAMPLES / 8));
+  TEST_ASSERT_TRUE(Sidetone::sounding());
+  peak(RAMP_SAMPLES);
+  TEST_ASSERT_FALSE(Sidetone::sounding());
+  TEST_ASSERT_EQUAL(0, peak(SIDETONE_RATE / 100));
+}
+
+void test_end_stops_a_keyed_tone(void)
+{
+  Sidetone::key(true);
+  peak(3 * RAMP_SAMPLES);
+  Sidetone::end();
+  TEST_ASSERT_FALSE(Sidetone::sounding());
+  TEST_ASSERT_EQUAL(LOW, digitalRead(PIN));
+}
+
+// A Morse object on the sidetone stops it when it goes, keyed or not
+void test_morse_ends_its_sidetone(void)
+{
+  {
+    Morse morse(PIN, 20, 2);
+    Sidetone::key(true);
+    peak(3 * RAMP_SAMPLES);
+    TEST_ASSERT_EQUAL(HIGH, digitalRead(PIN));
+  }
+  TEST_ASSERT_FALSE(Sidetone::sounding());
+  TEST_ASSERT_EQUAL(LOW, digitalRead(PIN));
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_pitch);
+  RUN_TEST(test_pitch_is_clamped);
+  RUN_TEST(test_attack_is_ramped);
+  RUN_TEST(test_keying_has_no_steps);
+  RUN_TEST(test_release_goes_silent);
+  RUN_TEST(test_end_stops_a_keyed_tone);
+  RUN_TEST(test_morse_ends_its_sidetone);
+  return UNITY_END();
+}
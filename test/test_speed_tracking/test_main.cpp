@@ -0,0 +1,189 @@
+/*
+  Speed tracking of morseDecoder on the native build: the keyer pin is
+  written with the sender's timing (MorseTiming), the decoder captures
+  the edges and has to follow a sender faster or slower than it was set.
+*/
+
+#include <Arduino.h>
+#include <MorseEnDecoder.h>
+#include <MorseTiming.h>
+#include <unity.h>
+
+#define KEY_PIN 4     // active low, like the trainer's keyer input
+
+static char out[128];
+
+// Keys s at wpm on the keyer pin, decoding as it goes
+static const char *key(morseDecoder &d, const char *s, byte wpm)
+{
+  MorseTiming timing;
+  uint16_t prog[400];
+  int len = 0;
+
+  timing.setSpeed(wpm, 0);
+  int n = timing.compile(s, prog, sizeof(prog) / sizeof(prog[0]));
+  TEST_ASSERT_GREATER_THAN(0, n);
+  for (int i = 0; i <= n; i++) {
+    if (i < n) {
+      digitalWrite(KEY_PIN, prog[i] & MORSE_TIMING_MARK ? LOW : HIGH);
+      nativeAdvance(MorseTiming::duration(prog[i]));
+    } else {
+      nativeAdvance(10 * 1200000UL / wpm);  // let the last word end
+    }
+    d.decode();
+    while (d.available() && len < (int)sizeof(out) - 1)
+      out[len++] = d.read();
+  }
+  out[len] = '\0';
+  return out;
+}
+
+void setUp(void)
+{
+  digitalWrite(KEY_PIN, HIGH);
+}
+
+void tearDown(void)
+{
+}
+
+void test_follows_a_faster_sender(void)
+{
+  morseDecoder d(KEY_PIN, MORSE_KEYER, MORSE_ACTIVE_LOW);
+  d.setspeed(13);
+  TEST_ASSERT_TRUE(d.beginCapture());
+  const char *text = key(d, "PARIS PARIS PARIS PARIS ", 30);
+  TEST_ASSERT_INT_WITHIN(2, 30, d.getspeed());
+  TEST_ASSERT_NOT_NULL_MESSAGE(strstr(text, "PARIS PARIS "), text);
+}
+
+void test_follows_a_slower_sender(void)
+{
+  morseDecoder d(KEY_PIN, MORSE_KEYER, MORSE_ACTIVE_LOW);
+  d.setspeed(30);
+  TEST_ASSERT_TRUE(d.beginCapture());
+  const char *text = key(d, "PARIS PARIS PARIS ", 12);
+  TEST_ASSERT_INT_WITHIN(1, 12, d.getspeed());
+  TEST_ASSERT_NOT_NULL_MESSAGE(strstr(text, "PARIS PARIS "), text);
+}
+
+// Changing speed in the middle of a text
+void test_follows_a_speed_change(void)
+{
+  morseDecoder d(KEY_PIN, MORSE_KEYER, MORSE_ACTIVE_LOW);
+  d.setspeed(20);
+  TEST_ASSERT_TRUE(d.beginCapture());
+  key(d, "CQ CQ ", 20);
+  const char *text = key(d, "DE ZS6JGP ZS6JGP ", 35);
+  TEST_ASSERT_INT_WITHIN(2, 35, d.getspeed());
+  TEST_ASSERT_NOT_NULL_MESSAGE(strstr(text, "ZS6JGP "), text);
+}
+
+void test_fixed_speed_stays(void)
+{
+  morseDecoder d(KEY_PIN, MORSE_KEYER, MORSE_ACTIVE_LOW);
+  d.setspeed(20);
+  d.engine.adaptiveSpeed = false;
+  TEST_ASSERT_TRUE(d.beginCapture());
+  TEST_ASSERT_EQUAL_STRING("PARIS PARIS ", key(d, "PARIS PARIS ", 24));
+  TEST_ASSERT_EQUAL(20, d.getspeed());
+}
+
+// Speed ramps: a sender that changes speed, either at once or a little
+// with every character. Each case keys RAMP_CHARS characters, reports
+// how many characters after the change it took the decoder to lock on
+// (from there on every character right and the speed within 10%) and
+// how many it got wrong before, and fails if locking took too long.
+#define RAMP_CHARS 60
+#define RAMP_START 10        // characters at the first speed
+#define RAMP_LOCK 4          // characters allowed to lock on
+
+struct ramp {
+  const char *name;
+  byte from, to;             // WPM
+  byte steps;                // characters the change is spread over, 1: at once
+};
+
+static const ramp ramps[] = {
+  {"step 10 -> 40", 10, 40, 1},
+  {"step 40 -> 15", 40, 15, 1},
+  {"step 20 -> 35", 20, 35, 1},
+  {"ramp 10 -> 40 over 20", 10, 40, 20},
+  {"ramp 40 -> 15 over 20", 40, 15, 20},
+  {"ramp 15 -> 30 over 10", 15, 30, 10},
+};
+
+static byte rampSpeed(const ramp &r, int c)
+{
+  if (c < RAMP_START) return r.from;
+  int k = c - RAMP_START + 1;
+  if (k >= r.steps) return r.to;
+  return r.from + (r.to - r.from) * k / r.steps;
+}
+
+// Keys c and its gap at wpm, returns the first character decoded
+static char keyChar(morseDecoder &d, char c, byte wpm)
+{
+  MorseTiming timing;
+  uint16_t prog[MORSE_TIMING_CHAR];
+  char got = 0;
+
+  timing.setSpeed(wpm, 0);
+  byte n = timing.compile(c, prog, MORSE_TIMING_CHAR);
+  for (byte i = 0; i < n; i++) {
+    digitalWrite(KEY_PIN, prog[i] & MORSE_TIMING_MARK ? LOW : HIGH);
+    nativeAdvance(MorseTiming::duration(prog[i]));
+    d.decode();
+    while (d.available()) {
+      char r = d.read();
+      if (r != ' ' && !got) got = r;
+    }
+  }
+  return got;
+}
+
+void test_speed_ramps(void)
+{
+  static const char koch[] = "KMRSUAPTLOWI.NJEF0YV,G5/Q9ZH38B?4271C6DX";
+  uint32_t seed = 1;
+
+  for (unsigned int i = 0; i < sizeof(ramps) / sizeof(ramps[0]); i++) {
+    const ramp &r = ramps[i];
+    morseDecoder d(KEY_PIN, MORSE_KEYER, MORSE_ACTIVE_LOW);
+    d.setspeed(r.from);
+    TEST_ASSERT_TRUE(d.beginCapture());
+
+    int lastBad = RAMP_START - 1;  // last character wrong or off speed
+    int wrong = 0;
+    for (int c = 0; c < RAMP_CHARS; c++) {
+      seed = seed * 1103515245 + 12345;
+      char sent = koch[(seed >> 16) % (sizeof(koch) - 1)];
+      byte wpm = rampSpeed(r, c);
+      boolean right = keyChar(d, sent, wpm) == sent;
+      if (!right && c >= RAMP_START) wrong++;
+      if (!right || abs(d.getspeed() - wpm) * 10 > wpm)
+        lastBad = c;
+    }
+    keyChar(d, ' ', r.to);
+    d.endCapture();
+
+    int lock = lastBad - (RAMP_START - 1);
+    char msg[120];
+    snprintf(msg, sizeof(msg), "%-22s locked after %2d characters, %2d of %d wrong, %d WPM at the end",
+             r.name, lock, wrong, RAMP_CHARS - RAMP_START, d.getspeed());
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_LESS_THAN_MESSAGE(RAMP_CHARS - RAMP_START - 10, lock, r.name);  // locked, and stayed
+    TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(r.steps - 1 + RAMP_LOCK, lock, r.name);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_follows_a_faster_sender);
+  RUN_TEST(test_follows_a_slower_sender);
+  RUN_TEST(test_follows_a_speed_change);
+  RUN_TEST(test_fixed_speed_stays);
+  RUN_TEST(test_speed_ramps);
+  return UNITY_END();
+}
@@ -0,0 +1,189 @@
+/*
+  The Goertzel tone detector of morseDecoder (MORSE_AUDIO) on the native
+  build: synthetic audio is fed through captureSample() as the ADC
+  interrupt would, and decode() runs every 16 samples.
+*/
+
+#include <Arduino.h>
+#include <MorseEnDecoder.h>
+#include <math.h>
+#include <time.h>
+#include <unity.h>
+
+#define WPM 20
+#define TONE_HZ 700
+#define LEVEL 10      // tone amplitude, ADC counts
+#define NOISE 4       // noise sigma, ADC counts
+
+static uint32_t noiseState;
+
+// Roughly gaussian noise, the same every run
+static double noise(void)
+{
+  double g = 0;
+  for (int i = 0; i < 12; i++) {
+    noiseState = noiseState * 1103515245 + 12345;
+    g += (noiseState >> 16 & 0x7fff) / 32768.0;
+  }
+  return g - 6;
+}
+
+// Morse of PARIS in dot units, 1: tone
+static unsigned int paris(char *units)
+{
+  static const char * const codes[] = {".--.", ".-", ".-.", "..", "..."};
+  unsigned int n = 0;
+  for (int c = 0; c < 5; c++) {
+    for (const char *e = codes[c]; *e; e++) {
+      for (int i = *e == '-' ? 3 : 1; i > 0; i--)
+        units[n++] = 1;
+      units[n++] = 0;
+    }
+    units[n++] = 0;
+    units[n++] = 0;
+  }
+  for (int i = 0; i < 4; i++)
+    units[n++] = 0;
+  return n;  // 50
+}
+
+// Plays PARIS twice at hz with the given tone amplitude and noise sigma
+// (8 bit ADC counts), returns what was decoded
+static const char *listen(double hz, double amplitude, double sigma, morseDecoder &d)
+{
+  static char out[32];
+  char units[60];
+  unsigned int n = paris(units);
+  double fs = MORSE_SAMPLE_RATE;
+  double unit = 1.2 / WPM;
+  unsigned long samples = (unsigned long)((2 * n + 16) * unit * fs);
+  int len = 0;
+
+  noiseState = 1;
+  for (unsigned long i = 0; i < samples; i++) {
+    long u = (long)(i / (unit * fs)) - 8;  // 8 units of silence first
+    double v = 10 + sigma * noise();       // with some DC offset
+    if (u >= 0 && u < (long)(2 * n) && units[u % n])
+      v += amplitude * sin(2 * PI * hz * i / fs);
+    int s = (int)(128 + v);
+    morseDecoder::captureSample(s < 0 ? 0 : s > 255 ? 255 : s);
+    if (i % 16 == 15) {
+      d.decode();
+      while (d.available() && len < (int)sizeof(out) - 1)
+        out[len++] = d.read();
+    }
+  }
+  out[len] = '\0';
+  return out;
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_decodes_tone_in_noise(void)
+{
+  morseDecoder d(A0, MORSE_AUDIO, MORSE_ACTIVE_HIGH);
+  d.setspeed(WPM);
+  TEST_ASSERT_TRUE(d.beginTone(TONE_HZ));
+  const char *text = listen(TONE_HZ + 13, LEVEL, NOISE, d);  // a slightly detuned sender
+  TEST_ASSERT_NOT_NULL_MESSAGE(strstr(text, "PARIS"), text);
+  TEST_ASSERT_EQUAL(0, d.sampleOverflows);
+}
+
+void test_noise_alone_decodes_nothing(void)
+{
+  morseDecoder d(A0, MORSE_AUDIO, MORSE_ACTIVE_HIGH);
+  d.setspeed(WPM);
+  TEST_ASSERT_TRUE(d.beginTone(TONE_HZ));
+  TEST_ASSERT_EQUAL_STRING("", listen(TONE_HZ, 0, 2 * NOISE, d));
+}
+
+// A tone as loud an octave off is outside the filter
+void test_other_frequency_is_ignored(void)
+{
+  morseDecoder d(A0, MORSE_AUDIO, MORSE_ACTIVE_HIGH);
+  d.setspeed(WPM);
+  TEST_ASSERT_TRUE(d.beginTone(TONE_HZ));
+  TEST_ASSERT_EQUAL_STRING("", listen(2 * TONE_HZ, LEVEL, NOISE, d));
+}
+
+// Samples the decoder doesn't get to are counted, not written over
+void test_full_sample_buffer_counts_overflows(void)
+{
+  morseDecoder d(A0, MORSE_AUDIO, MORSE_ACTIVE_HIGH);
+  TEST_ASSERT_TRUE(d.beginTone(TONE_HZ));
+  for (int i = 0; i < MORSE_SAMPLE_BUFFER_SIZE + 10; i++)
+    morseDecoder::captureSample(128);
+  TEST_ASSERT_EQUAL(11, d.sampleOverflows);
+  d.decode();
+  morseDecoder::captureSample(128);
+  TEST_ASSERT_EQUAL(11, d.sampleOverflows);
+}
+
+void test_begin_tone_checks_its_arguments(void)
+{
+  morseDecoder keyer(4, MORSE_KEYER, MORSE_ACTIVE_LOW);
+  morseDecoder audio(A0, MORSE_AUDIO, MORSE_ACTIVE_HIGH);
+  TEST_ASSERT_FALSE(keyer.beginTone(TONE_HZ));
+  TEST_ASSERT_FALSE(audio.beginTone(0));
+  TEST_ASSERT_FALSE(audio.beginTone(MORSE_SAMPLE_RATE / 2));
+  TEST_ASSERT_TRUE(audio.beginTone(MORSE_SAMPLE_RATE / 2 - 1));
+}
+
+// CPU time for a second of audio at MORSE_SAMPLE_RATE: every sample
+// through captureSample(), as the ADC interrupt does, and decode() every
+// 16 samples. Host time, best of 5 runs of 10 s of the same audio.
+void test_benchmark(void)
+{
+  static byte audio[MORSE_SAMPLE_RATE];
+  noiseState = 1;
+  for (unsigned long i = 0; i < MORSE_SAMPLE_RATE; i++) {
+    boolean mark = i * 10 / MORSE_SAMPLE_RATE % 2 == 0;  // 50 ms marks and spaces
+    double v = NOISE * noise() + (mark ? LEVEL * sin(2 * PI * TONE_HZ * i / MORSE_SAMPLE_RATE) : 0);
+    audio[i] = (byte)(128 + v);
+  }
+
+  morseDecoder d(A0, MORSE_AUDIO, MORSE_ACTIVE_HIGH);
+  d.setspeed(WPM);
+  TEST_ASSERT_TRUE(d.beginTone(TONE_HZ));
+  double best = 1e30;
+  for (int run = 0; run < 5; run++) {
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int second = 0; second < 10; second++)
+      for (unsigned long i = 0; i < MORSE_SAMPLE_RATE; i++) {
+        morseDecoder::captureSample(audio[i]);
+        if (i % 16 == 15) {
+          d.decode();
+          while (d.available()) d.read();
+        }
+      }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double us = ((t1.tv_sec - t0.tv_sec) * 1e6 + (t1.tv_nsec - t0.tv_nsec) / 1e3) / 10;
+    if (us < best) best = us;
+  }
+  TEST_ASSERT_EQUAL(0, d.sampleOverflows);
+
+  char msg[120];
+  snprintf(msg, sizeof(msg), "%lu Hz audio: %.0f us per second (%.3f%% of this host's CPU), %.0f ns per sample",
+           (unsigned long)MORSE_SAMPLE_RATE, best, best / 1e4, best * 1e3 / MORSE_SAMPLE_RATE);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_LESS_THAN(100000, (long)best);  // well under a tenth of real time
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_decodes_tone_in_noise);
+  RUN_TEST(test_noise_alone_decodes_nothing);
+  RUN_TEST(test_other_frequency_is_ignored);
+  RUN_TEST(test_full_sample_buffer_counts_overflows);
+  RUN_TEST(test_begin_tone_checks_its_arguments);
+  RUN_TEST(test_benchmark);
+  return UNITY_END();
+}
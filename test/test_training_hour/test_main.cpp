@@ -0,0 +1,141 @@
+/*
+  An hour of training on the native build, as a benchmark: the trainer
+  of src/main.cpp sends its groups, a simulated student keys each one
+  back on the keyer pin, and after 3600 s of virtual time SELECT ends
+  the session. Prints how long that took in wall time.
+*/
+
+#include <Arduino.h>
+#include <MorseTiming.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <unity.h>
+
+void setup();
+void loop();
+
+#define KEY_PIN 4        // morseInPin, active low
+#define STUDENT_WPM 20
+#define HOUR 3600000UL   // ms
+
+// What the trainer printed: the group it sent, and the rounds so far
+static char line[64];
+static unsigned int lineLen;
+static char sent[17];
+static unsigned int sentLen;
+static boolean sending;
+static unsigned long rounds, wrong;
+
+// The student's keying: key down from marks[i] to marks[i + 1], in us
+static unsigned long long marks[2 * 6 * 16];
+static unsigned int markCount;
+
+// Keys the group back from 300 ms on, every 20th one with a wrong first
+// character, so the trainer repeats it
+static void answer()
+{
+  char text[18];
+  memcpy(text, sent, sentLen);
+  text[sentLen] = '\0';
+  if (++rounds % 20 == 0) {
+    text[0] = text[0] == 'E' ? 'T' : 'E';
+    wrong++;
+  }
+
+  MorseTiming timing;
+  uint16_t prog[6 * 16];
+  timing.setSpeed(STUDENT_WPM, 0);
+  int n = timing.compile(text, prog, sizeof(prog) / sizeof(prog[0]));
+  unsigned long long t = nativeTime() + 300000;
+  markCount = 0;
+  for (int i = 0; i < n; i++) {
+    if (prog[i] & MORSE_TIMING_MARK) {
+      marks[markCount++] = t;
+      marks[markCount++] = t + MorseTiming::duration(prog[i]);
+    }
+    t += MorseTiming::duration(prog[i]);
+  }
+}
+
+static void capture(uint8_t c)
+{
+  if (c == '\n') {
+    lineLen = 0;
+    sending = false;
+    return;
+  }
+  if (sending && sentLen < sizeof(sent) - 1)
+    sent[sentLen++] = c;
+  if (lineLen < sizeof(line) - 1)
+    line[lineLen++] = c;
+  line[lineLen] = '\0';
+  if (!strcmp(line, "Top of the send loop  ")) {
+    sending = true;
+    sentLen = 0;
+  } else if (!strcmp(line, "Top of the check loop ")) {
+    answer();
+  }
+}
+
+static int keyer(uint8_t pin, unsigned long us)
+{
+  if (pin != KEY_PIN) return HIGH;
+  unsigned long long t = nativeTime();
+  for (unsigned int i = 0; i < markCount; i += 2)
+    if (t >= marks[i] && t < marks[i + 1])
+      return LOW;
+  return HIGH;
+}
+
+// A session that doesn't end is a failure, not a hung test run
+static void timeout(int)
+{
+  static const char msg[] = "\ntimed out, the trainer didn't stop\n";
+  write(2, msg, sizeof(msg) - 1);
+  _exit(1);
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+void test_training_hour(void)
+{
+  unsigned long t = millis();
+  Serial.inject(" ", t + 1500);          // SELECT "Start"
+  Serial.inject(" ", t + 1500 + HOUR);   // SELECT ends the session
+
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  loop();
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  double wall = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+  double virt = (millis() - t) / 1000.0;
+
+  char msg[120];
+  snprintf(msg, sizeof(msg), "%.0f s of training in %.2f s wall time (%.0fx), %lu groups, %lu keyed wrong",
+           virt, wall, virt / wall, rounds, wrong);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_GREATER_OR_EQUAL(3600, (long)virt);
+  TEST_ASSERT_LESS_THAN(3700, (long)virt);
+  TEST_ASSERT_GREATER_THAN(1000, rounds);  // the student kept up
+  TEST_ASSERT_LESS_THAN(120, (long)wall);  // an hour in seconds, not minutes
+}
+
+int main(int argc, char **argv)
+{
+  signal(SIGALRM, timeout);
+  alarm(300);
+  nativeSetSerialWriter(capture);
+  nativeSetPinReader(keyer);
+  setup();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_training_hour);
+  return UNITY_END();
+}
@@ -0,0 +1,180 @@
+/*
+  morsecal.cpp - sender timing check on the virtual clock
+
+  Runs the PARIS calibration of the trainer on the host: the Morse
+  sender plays from its timer interrupt and the meter reads the key
+  edges from the pin change capture of morseDecoder, both emulated on
+  the virtual clock of lib/ArduinoNative. Prints the measured speed,
+  dot and gaps against the exact ones for a grid of speeds, Farnsworth
+  speeds and speed trims.
+
+  Build (from the repository root):
+    g++ -std=c++11 -O2 -DARDUINO=10805 -Ilib/ArduinoNative -Ilib/Morse \
+      -Ilib/Morse_EnDecoder tools/morsecal.cpp \
+      lib/ArduinoNative/ArduinoNative.cpp lib/ArduinoNative/Print.cpp \
+      lib/ArduinoNative/Wire.cpp lib/Morse/Morse.cpp lib/Morse/MorseTiming.cpp \
+      lib/Morse/MorseMeter.cpp lib/Morse/MorseCode.cpp lib/Morse/Sidetone.cpp \
+      lib/Morse/FastPin.cpp \
+      lib/Morse_EnDecoder/MorseEnDecoder.cpp \
+      lib/Morse_EnDecoder/MorseEngine.cpp -o morsecal
+
+  Usage: morsecal [options]
+    -n words   PARIS words sent per condition (default 10)
+    -l us      virtual time one pass of the sending loop takes (default
+               100), the timer and pin change interrupts run on time
+               whatever it is
+    -r ppm     fail (exit 1) if a measured speed is further than ppm
+               parts per million off the exact one
+    -t us      fail (exit 1) if an average dot or gap is further than
+               us off the exact one
+
+  The sender rounds every run to Timer1 ticks (64 us at 16 MHz) but
+  carries the rounding on, so the speed comes out exact over a word and
+  single lengths are off by less than a tick.
+
+  Every condition also checks the correction the PARIS test would save:
+  the meter expects the untrimmed speed, so from any trim it must work
+  out the trim that sends exactly that, 0. Any other result fails.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "Arduino.h"
+#include "Morse.h"
+#include "MorseMeter.h"
+#include "MorseEnDecoder.h"
+
+// Conditions
+static const byte speeds[] = { 5, 13, 20, 25, 35, 50 };
+static const byte farnsworths[] = { 0, 5, 10, 18 };    // overall speed, 0 = off
+static const int trims[] = { -100, -17, 0, 25, 100 };  // 1/1000
+
+#define COUNT(a) (int)(sizeof(a) / sizeof(a[0]))
+
+static const byte key_pin = 5;
+static unsigned long loopTime = 100;   // us per pass of the sending loop
+
+// The native main() runs these, this program has its own
+void setup() {}
+void loop() {}
+
+//====================
+// One condition
+//====================
+
+struct result
+{
+  double wpm;         // measured
+  int trim;           // correction the meter suggests
+  double dot;         // us
+  double charGap;
+  double wordGap;
+};
+
+static bool measure(byte wpm, byte farns, int trim, int words, result *r)
+{
+  morseDecoder input(key_pin, MORSE_KEYER, MORSE_ACTIVE_HIGH);
+  MorseMeter meter;
+  meter.begin(wpm, farns);
+
+  Morse morse(key_pin, wpm, 0);
+  morse.farnsworth(farns);
+  morse.trim(trim);
+  if (!input.beginCapture())
+    return false;
+
+  // One extra word, the first only starts the meter
+  const char *text = "PARIS ";
+  int sent = 0;
+  boolean down;
+  unsigned long t;
+  while (sent < (words + 1) * 6 || !morse.done()) {
+    if (sent < (words + 1) * 6 && morse.remaining() < 2 && morse.queue(text[sent % 6]))
+      sent++;
+    while (input.readEdge(&down, &t))
+      meter.edge(down, t);
+    nativeAdvance(loopTime);   // the rest of the main loop
+  }
+  while (input.readEdge(&down, &t))
+    meter.edge(down, t);
+
+  if ((int)meter.words() != words)
+    return false;
+  r->wpm = 60e6 / meter.period();
+  r->trim = meter.trim(trim);
+  r->dot = meter.dot();
+  r->charGap = meter.charGap();
+  r->wordGap = meter.wordGap();
+  return true;
+}
+
+//====================
+// main
+//====================
+
+static void usage()
+{
+  fprintf(stderr, "usage: morsecal [-n words] [-l us] [-r ppm] [-t us]\n");
+  exit(2);
+}
+
+int main(int argc, char **argv)
+{
+  int words = 10;
+  double limit = 0;
+  double lengthLimit = 0;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:l:r:t:")) != -1) {
+    switch (opt) {
+      case 'n': words = atoi(optarg); break;
+      case 'l': loopTime = strtoul(optarg, NULL, 10); break;
+      case 'r': limit = atof(optarg); break;
+      case 't': lengthLimit = atof(optarg); break;
+      default: usage();
+    }
+  }
+  if (words < 1) usage();
+
+  printf("  wpm farns  trim |     WPM     exact    ppm |    dot   us | char gap   us | word gap   us | cal\n");
+  double worst = 0;
+  double worstLength = 0;
+  int fail = 0;
+  for (int a = 0; a < COUNT(speeds); a++) {
+    for (int b = 0; b < COUNT(farnsworths); b++) {
+      byte c = speeds[a];
+      byte s = farnsworths[b];
+      if (s >= c) continue;
+      for (int k = 0; k < COUNT(trims); k++) {
+        result r;
+        if (!measure(c, s, trims[k], words, &r)) {
+          printf("%5d %5d %5d | no measurement\n", c, s, trims[k]);
+          fail = 1;
+          continue;
+        }
+
+        // Exact lengths, see MorseTiming.cpp
+        double f = 1000.0 / (1000 + trims[k]);
+        double dot = 1.2e6 / c * f;
+        double unit = s ? (60.0 * c - 37.2 * s) / (19.0 * s * c) * 1e6 * f : dot;
+        double w = (s ? s : c) / f;
+
+        double err = fabs(r.wpm - w) / w * 1e6;
+        double length[3] = { r.dot - dot, r.charGap - 3 * unit, r.wordGap - 7 * unit };
+        printf("%5d %5d %5d | %7.3f %9.5f %6.1f | %6.0f %4.0f | %8.0f %4.0f | %8.0f %4.0f | %3d\n",
+               c, s, trims[k], r.wpm, w, err, r.dot, length[0], r.charGap, length[1], r.wordGap, length[2], r.trim);
+        if (err > worst) worst = err;
+        if (limit > 0 && err > limit) fail = 1;
+        for (int i = 0; i < 3; i++) {
+          if (fabs(length[i]) > worstLength) worstLength = fabs(length[i]);
+          if (lengthLimit > 0 && fabs(length[i]) > lengthLimit) fail = 1;
+        }
+        if (r.trim != 0) fail = 1;
+      }
+    }
+  }
+  printf("worst %.1f ppm, %.0f us\n", worst, worstLength);
+  return fail;
+}
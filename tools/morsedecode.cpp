@@ -0,0 +1,475 @@
+/*
+  morsedecode.cpp - decode recorded keying traces on the host
+
+  Feeds keyer traces through the same morseEngine the trainer decodes
+  with, and prints the text and the timing of the elements, so a batch
+  of student recordings can be scored at once.
+
+  Build (from the repository root, POSIX):
+    g++ -std=c++11 -O2 -pthread -Ilib/Morse -Ilib/Morse_EnDecoder \
+      tools/morsedecode.cpp lib/Morse_EnDecoder/MorseEngine.cpp \
+      lib/Morse/MorseCode.cpp -o morsedecode
+
+  Usage: morsedecode [options] file...
+    -j n     decode n files at once (default: one per core)
+    -l       active low: level 0 is key down
+    -g us    drop marks and spaces shorter than this (default 1000)
+    -w wpm   starting speed (default 20)
+    -f       fixed speed, do not follow the sender
+    -s       soft decision decoding (morseEngine::softDecision)
+    -t unit  time unit of the traces: s, ms, us or ns
+    -c n     column of the level, counted from 0 (default 1)
+    -q       text only, no timing statistics
+    -b n     benchmark: decode n million synthetic elements per thread
+
+  Trace files, one edge or sample per line, lines that do not start
+  with a number (headers, # comments) are skipped:
+    logic analyzer CSV  "time,level[,...]", time in seconds
+    edge list           "time level", time in us
+  Files are memory mapped and read once from start to end, so they can
+  be larger than memory.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MorseEngine.h"
+#include "MorseCode.h"
+
+#define UNIT_AUTO 0
+
+static int opt_jobs;
+static bool opt_active_low;
+static long opt_glitch = 1000;
+static int opt_wpm = 20;
+static bool opt_fixed;
+static bool opt_soft;
+static long opt_unit = UNIT_AUTO;   // ns per trace time unit
+static int opt_column = 1;
+static bool opt_quiet;
+
+// Bytes released from the page cache mapping once read
+#define DROP_BYTES (64L << 20)
+
+
+
+//==================
+// Timing statistics
+//==================
+
+enum { DOT, DASH, GAP_ELEMENT, GAP_CHAR, GAP_WORD, KINDS };
+static const char *kind_name[KINDS] = { "dot", "dash", "element gap", "char gap", "word gap" };
+
+struct Stat
+{
+  long n;
+  double sum, sum2;   // ms
+  double units;       // sum of durations in dot lengths at the time
+};
+
+struct Trace
+{
+  morseEngine engine;
+  std::string text;
+  Stat stat[KINDS];
+  long elements;      // marks and spaces fed to the engine
+  bool level;         // last level fed to the engine
+  long time;          // ... and its time in us
+  bool pending;       // an edge waiting to pass the glitch filter
+  bool pendLevel;
+  long pendTime;
+  bool started;
+  long long origin;   // first time in the file, in ns
+};
+
+static void trace_init(Trace &t)
+{
+  t.engine.setspeed(opt_wpm);
+  t.engine.adaptiveSpeed = !opt_fixed;
+  t.engine.softDecision = opt_soft;
+  memset(t.stat, 0, sizeof(t.stat));
+  t.elements = 0;
+  t.level = false;
+  t.time = 0;
+  t.pending = false;
+  t.started = false;
+}
+
+static void trace_drain(Trace &t)
+{
+  while (t.engine.available())
+    t.text += t.engine.read();
+}
+
+static void trace_count(Trace &t, bool mark, long duration)
+{
+  double dot = t.engine.dotLength();
+  double units = duration / dot;
+  int kind;
+  if (mark)
+    kind = units < 2 ? DOT : DASH;
+  else if (units < 2)
+    kind = GAP_ELEMENT;
+  else if (units < 5)
+    kind = GAP_CHAR;
+  else if (units < 14)
+    kind = GAP_WORD;
+  else
+    return;   // a pause, not part of the sending
+  Stat &s = t.stat[kind];
+  double ms = duration / 1000.0;
+  s.n++;
+  s.sum += ms;
+  s.sum2 += ms * ms;
+  s.units += units;
+}
+
+// Hand the edge to the engine, after the element it ends
+static void trace_commit(Trace &t, bool level, long time)
+{
+  if (t.elements > 0)
+    trace_count(t, t.level, time - t.time);
+  t.engine.signal(level, time);
+  trace_drain(t);
+  t.level = level;
+  t.time = time;
+  t.elements++;
+}
+
+static void trace_edge(Trace &t, bool level, long time)
+{
+  if (t.pending) {
+    if (level == t.pendLevel)
+      return;   // the same level sampled again
+    if (time - t.pendTime < opt_glitch) {
+      // The pending pulse was too short, it never happened
+      t.pending = false;
+      return;
+    }
+    trace_commit(t, t.pendLevel, t.pendTime);
+    t.pending = false;
+  } else if (level == t.level && t.elements > 0) {
+    return;
+  }
+  t.pending = true;
+  t.pendLevel = level;
+  t.pendTime = time;
+}
+
+static void trace_end(Trace &t)
+{
+  if (t.pending)
+    trace_commit(t, t.pendLevel, t.pendTime);
+  // Let the last character and word space out
+  t.engine.update(t.time + 20 * t.engine.dotLength());
+  trace_drain(t);
+}
+
+static void trace_report(Trace &t, const char *name, std::string &out)
+{
+  char line[160];
+  while (!t.text.empty() && t.text[t.text.size() - 1] == ' ')
+    t.text.erase(t.text.size() - 1);
+  out += name;
+  out += ": ";
+  out += t.text;
+  out += '\n';
+  if (opt_quiet)
+    return;
+  snprintf(line, sizeof(line), "  %ld elements, %d wpm at the end, %u characters dropped\n",
+           t.elements, t.engine.getspeed(), t.engine.droppedChars);
+  out += line;
+  for (int k = 0; k < KINDS; k++) {
+    Stat &s = t.stat[k];
+    if (s.n == 0)
+      continue;
+    double mean = s.sum / s.n;
+    double var = s.sum2 / s.n - mean * mean;
+    snprintf(line, sizeof(line), "  %-12s %8ld  mean %7.1f ms  sd %6.1f ms  %5.2f dots\n",
+             kind_name[k], s.n, mean, sqrt(var > 0 ? var : 0), s.units / s.n);
+    out += line;
+  }
+}
+
+
+
+//==================
+// Trace parsing
+//==================
+
+// Parses a decimal number at p into whole time units and billionths of a
+// unit, so "0.000125" s is read exactly. Returns false if there is none.
+static bool parse_number(const char *&p, const char *end, long long &whole, long long &frac)
+{
+  const char *start = p;
+  bool negative = false;
+  long long scale = 1000000000LL;
+  whole = frac = 0;
+  if (p < end && *p == '-') {
+    negative = true;
+    p++;
+  }
+  if (p == end || !((*p >= '0' && *p <= '9') || *p == '.'))
+    return false;
+  while (p < end && *p >= '0' && *p <= '9')
+    whole = whole * 10 + (*p++ - '0');
+  if (p < end && *p == '.') {
+    p++;
+    while (p < end && *p >= '0' && *p <= '9') {
+      if (scale > 1) {
+        scale /= 10;
+        frac += (*p - '0') * scale;
+      }
+      p++;
+    }
+  }
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    // Rare in exports, take the slow way
+    char buf[48];
+    size_t n = 0;
+    for (p = start; p < end && n < sizeof(buf) - 1 && strchr("0123456789.eE+-", *p); p++)
+      buf[n++] = *p;
+    buf[n] = 0;
+    double v = fabs(strtod(buf, 0));
+    whole = (long long)v;
+    frac = (long long)((v - whole) * 1e9 + 0.5);
+  }
+  if (negative) {
+    whole = -whole;
+    frac = -frac;
+  }
+  return true;
+}
+
+static void trace_parse(Trace &t, const char *p, const char *end, const char *base, int fd)
+{
+  long unit = opt_unit;
+  const char *dropped = base;
+  while (p < end) {
+    const char *eol = (const char *)memchr(p, '\n', end - p);
+    if (!eol)
+      eol = end;
+    const char *q = p;
+    long long whole, frac;
+    while (q < eol && (*q == ' ' || *q == '\t'))
+      q++;
+    if (parse_number(q, eol, whole, frac)) {
+      if (unit == UNIT_AUTO) {
+        // CSV exports count in seconds, edge lists in microseconds
+        unit = (q < eol && *q == ',') ? 1000000000L : 1000L;
+      }
+      bool ok = true;
+      for (int c = 0; c < opt_column && ok; c++) {
+        while (q < eol && (*q == ',' || *q == ' ' || *q == '\t'))
+          q++;
+        if (c + 1 < opt_column) {
+          while (q < eol && *q != ',' && *q != ' ' && *q != '\t')
+            q++;
+        }
+        ok = q < eol;
+      }
+      if (ok && (*q == '0' || *q == '1')) {
+        long long ns = whole * unit + frac * unit / 1000000000LL;
+        if (!t.started) {
+          t.origin = ns;
+          t.started = true;
+        }
+        bool level = (*q == '1') != opt_active_low;
+        trace_edge(t, level, (long)((ns - t.origin) / 1000));
+      }
+    }
+    p = eol + 1;
+
+    if (fd >= 0 && p - dropped > 2 * DROP_BYTES) {
+      // Hand what has been read back, multi-gigabyte files must not pile up
+      madvise((void *)dropped, DROP_BYTES, MADV_DONTNEED);
+      dropped += DROP_BYTES;
+    }
+  }
+}
+
+static bool decode_file(const char *name, std::string &out)
+{
+  int fd = open(name, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) < 0) {
+    out += name;
+    out += ": cannot open\n";
+    if (fd >= 0)
+      close(fd);
+    return false;
+  }
+  Trace *t = new Trace;
+  trace_init(*t);
+  if (st.st_size > 0) {
+    void *map = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+      out += name;
+      out += ": cannot map\n";
+      close(fd);
+      delete t;
+      return false;
+    }
+    madvise(map, st.st_size, MADV_SEQUENTIAL);
+    const char *base = (const char *)map;
+    trace_parse(*t, base, base + st.st_size, base, fd);
+    munmap(map, st.st_size);
+  }
+  close(fd);
+  trace_end(*t);
+  trace_report(*t, name, out);
+  delete t;
+  return true;
+}
+
+
+
+//==================
+// Benchmark
+//==================
+
+// A synthetic edge list of PARIS at 20 WPM
+static void bench_trace(long elements, std::string &trace)
+{
+  const long dot = 60000;
+  long time = 0;
+  long n = 0;
+  char line[32];
+  trace.reserve(elements * 12);
+  while (n < elements) {
+    for (const char *c = "PARIS "; *c && n < elements; c++) {
+      uint8_t code = morseEncode(*c);
+      if (code == 1) {
+        time += 4 * dot;
+        continue;
+      }
+      for (; code > 1; code >>= 1) {
+        snprintf(line, sizeof(line), "%ld 1\n", time);
+        trace += line;
+        time += (code & 1) ? 3 * dot : dot;
+        snprintf(line, sizeof(line), "%ld 0\n", time);
+        trace += line;
+        time += code > 3 ? dot : 3 * dot;
+        n += 2;
+      }
+    }
+  }
+}
+
+// Decodes it, parsing included, returns the number of elements
+static long bench(const std::string &trace, std::string &text)
+{
+  Trace *t = new Trace;
+  trace_init(*t);
+  trace_parse(*t, trace.data(), trace.data() + trace.size(), trace.data(), -1);
+  trace_end(*t);
+  text = t->text.substr(0, 30);
+  long count = t->elements;
+  delete t;
+  return count;
+}
+
+
+
+//==================
+// main
+//==================
+
+static double seconds(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void usage(void)
+{
+  fprintf(stderr, "usage: morsedecode [-j jobs] [-l] [-g us] [-w wpm] [-f] [-s] [-t s|ms|us|ns]\n"
+                  "                   [-c column] [-q] [-b millions] file...\n");
+  exit(2);
+}
+
+int main(int argc, char **argv)
+{
+  long bench_elements = 0;
+  int c;
+  while ((c = getopt(argc, argv, "j:lg:w:fst:c:qb:")) != -1) {
+    switch (c) {
+      case 'j': opt_jobs = atoi(optarg); break;
+      case 'l': opt_active_low = true; break;
+      case 'g': opt_glitch = atol(optarg); break;
+      case 'w': opt_wpm = atoi(optarg); break;
+      case 'f': opt_fixed = true; break;
+      case 's': opt_soft = true; break;
+      case 'c': opt_column = atoi(optarg); break;
+      case 'q': opt_quiet = true; break;
+      case 'b': bench_elements = (long)(atof(optarg) * 1e6); break;
+      case 't':
+        if (!strcmp(optarg, "s")) opt_unit = 1000000000L;
+        else if (!strcmp(optarg, "ms")) opt_unit = 1000000L;
+        else if (!strcmp(optarg, "us")) opt_unit = 1000L;
+        else if (!strcmp(optarg, "ns")) opt_unit = 1L;
+        else usage();
+        break;
+      default: usage();
+    }
+  }
+  if (opt_column < 1 || opt_wpm < 1 || (optind == argc && bench_elements == 0))
+    usage();
+  if (opt_jobs < 1)
+    opt_jobs = std::thread::hardware_concurrency();
+  if (opt_jobs < 1)
+    opt_jobs = 1;
+
+  if (bench_elements > 0) {
+    std::vector<std::thread> threads;
+    std::vector<long> counts(opt_jobs);
+    std::vector<std::string> texts(opt_jobs);
+    std::string trace;
+    bench_trace(bench_elements, trace);
+    double t0 = seconds();
+    for (int i = 0; i < opt_jobs; i++)
+      threads.push_back(std::thread([&, i] { counts[i] = bench(trace, texts[i]); }));
+    long total = 0;
+    for (int i = 0; i < opt_jobs; i++) {
+      threads[i].join();
+      total += counts[i];
+    }
+    double dt = seconds() - t0;
+    printf("\"%s...\" %ld elements on %d threads in %.2f s: %.1f M elements/s\n",
+           texts[0].c_str(), total, opt_jobs, dt, total / dt / 1e6);
+    return 0;
+  }
+
+  // Workers take the next file, results are printed in argument order
+  int files = argc - optind;
+  std::vector<std::string> results(files);
+  std::atomic<int> next(0);
+  std::atomic<int> failed(0);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < opt_jobs && i < files; i++) {
+    threads.push_back(std::thread([&] {
+      int f;
+      while ((f = next++) < files) {
+        if (!decode_file(argv[optind + f], results[f]))
+          failed++;
+      }
+    }));
+  }
+  for (size_t i = 0; i < threads.size(); i++)
+    threads[i].join();
+  for (int f = 0; f < files; f++)
+    fputs(results[f].c_str(), results[f].find(": cannot ") != std::string::npos ? stderr : stdout);
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,398 @@
+/*
+  morsesweep.cpp - decoder threshold sweep and accuracy benchmark
+
+  Generates keying with controlled speed, weight and timing jitter, runs
+  morseEngine over a grid of decision thresholds (see setThresholds() in
+  MorseEngine.h) and prints how accurate and how quick each choice is.
+  The default thresholds are also run in soft decision mode.
+
+  Build (from the repository root):
+    g++ -std=c++11 -O2 -pthread -Ilib/Morse -Ilib/Morse_EnDecoder \
+      tools/morsesweep.cpp lib/Morse_EnDecoder/MorseEngine.cpp \
+      lib/Morse/MorseCode.cpp -o morsesweep
+
+  Usage: morsesweep [options]
+    -j n       threads (default: one per core)
+    -n words   words sent per condition (default 40)
+    -o file    also write every grid point and condition as CSV
+    -r cer     fail (exit 1) if the default thresholds make more than
+               cer percent character errors
+    -s rate    fail (exit 1) if the engine makes fewer than rate million
+               calls per second with the default thresholds
+
+  Accuracy is the character error rate: the edit distance between the
+  sent and the decoded text, in percent of the sent characters. Latency
+  is the time from the end of a character's last mark until the engine
+  hands out the character, in dots. The keying is the same for every
+  grid point, so the numbers compare threshold choices only.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "MorseEngine.h"
+#include "MorseCode.h"
+
+// Keying conditions
+static const int speeds[] = { 15, 25, 40, 60 };
+static const double jitters[] = { 0, 0.1, 0.2, 0.3 };   // sd, in dots
+static const double weights[] = { -0.25, 0, 0.25 };     // added to marks, taken from spaces, in dots
+
+// Threshold grid, 1/256 of the length each one scales with
+static const uint16_t markMins[] = { 32, 64, 96 };
+static const uint16_t dashSplits[] = { 96, 112, 128, 144, 160 };
+static const uint16_t charGaps[] = { 384, 448, 512, 576 };
+static const uint16_t wordGaps[] = { 128, 171, 213 };
+
+#define COUNT(a) (int)(sizeof(a) / sizeof(a[0]))
+
+// How often the engine is polled during a space, in dots; the trainer
+// calls decode() far more often, this only quantizes the latency
+#define POLL_STEP 0.125
+
+struct Condition
+{
+  int wpm;
+  double jitter, weight;
+  std::string text;         // what was sent
+  std::vector<long> time;   // edges in us, marks start at even indices
+  long elements;
+};
+
+struct Result
+{
+  long errors, chars;       // edit distance, sent characters
+  double latency;           // sum, in dots
+  long decoded;             // characters the latency is summed over
+  long events;              // engine calls
+};
+
+struct Point
+{
+  uint16_t markMin, dashSplit, charGap, wordGap;
+  bool soft;                    // soft decision mode
+  std::vector<Result> results;  // per condition
+  Result total;
+  double seconds;
+};
+
+static std::vector<Condition> conditions;
+
+
+
+//==================
+// Keying
+//==================
+
+static void make_condition(Condition &c, int words, unsigned seed)
+{
+  static const char koch[] = "KMRSUAPTLOWI.NJEF0Y,VG5/Q9ZH38B?427C1D6X";
+  std::mt19937 rng(seed);
+  std::normal_distribution<double> noise(0, 1);
+  double dot = 1200000.0 / c.wpm;
+  double t = 0;
+
+  // Jittered and weighted element of n dots
+  auto length = [&](int n, bool mark) {
+    double d = n + (mark ? c.weight : -c.weight) + noise(rng) * c.jitter;
+    return std::max(d, 0.1) * dot;
+  };
+
+  for (int w = 0; w < words; w++) {
+    int letters = 2 + rng() % 5;
+    if (w > 0) {
+      c.text += ' ';
+      t += length(7, false);
+    }
+    for (int l = 0; l < letters; l++) {
+      char ch = koch[rng() % (sizeof(koch) - 1)];
+      c.text += ch;
+      if (l > 0)
+        t += length(3, false);
+      for (uint8_t code = morseEncode(ch); code > 1; code >>= 1) {
+        c.time.push_back((long)t);
+        t += length((code & 1) ? 3 : 1, true);
+        c.time.push_back((long)t);
+        if (code > 3)
+          t += length(1, false);
+      }
+    }
+  }
+  c.elements = c.time.size();
+}
+
+static int edit_distance(const std::string &a, const std::string &b)
+{
+  std::vector<int> row(b.size() + 1);
+  for (size_t j = 0; j <= b.size(); j++)
+    row[j] = j;
+  for (size_t i = 1; i <= a.size(); i++) {
+    int diag = row[0];
+    row[0] = i;
+    for (size_t j = 1; j <= b.size(); j++) {
+      int up = row[j];
+      row[j] = std::min(std::min(row[j] + 1, row[j - 1] + 1), diag + (a[i - 1] != b[j - 1]));
+      diag = up;
+    }
+  }
+  return row[b.size()];
+}
+
+
+
+//==================
+// Decoding
+//==================
+
+static void drain(morseEngine &e, std::string &text, long markEnd, Result &r)
+{
+  long when;
+  while (e.available()) {
+    char ch = e.read(&when);
+    text += ch;
+    if (ch != ' ') {
+      r.latency += (when - markEnd) / (double)e.dotLength();
+      r.decoded++;
+    }
+  }
+}
+
+static void run(const Point &p, const Condition &c, Result &r)
+{
+  morseEngine e;
+  std::string text;
+  memset(&r, 0, sizeof(r));
+  e.setspeed(c.wpm);
+  e.setThresholds(p.markMin, p.dashSplit, p.charGap, p.wordGap);
+  e.softDecision = p.soft;
+
+  long markEnd = 0;
+  for (size_t i = 0; i < c.time.size(); i++) {
+    bool mark = (i & 1) == 0;
+    long end = i + 1 < c.time.size() ? c.time[i + 1] : c.time[i] + 20 * 1200000L / c.wpm;
+    e.signal(mark, c.time[i]);
+    r.events++;
+    drain(e, text, markEnd, r);
+    if (mark)
+      continue;
+    // Poll through the space, as decode() would
+    markEnd = c.time[i];
+    long step = (long)(POLL_STEP * e.dotLength());
+    for (long t = c.time[i] + step; t < end; t += step) {
+      e.update(t);
+      r.events++;
+      drain(e, text, markEnd, r);
+    }
+  }
+
+  while (!text.empty() && text[text.size() - 1] == ' ')
+    text.erase(text.size() - 1);
+  r.errors = edit_distance(c.text, text);
+  r.chars = c.text.size();
+}
+
+static void run_point(Point &p)
+{
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t0);
+  p.results.resize(conditions.size());
+  memset(&p.total, 0, sizeof(p.total));
+  for (size_t i = 0; i < conditions.size(); i++) {
+    Result &r = p.results[i];
+    run(p, conditions[i], r);
+    p.total.errors += r.errors;
+    p.total.chars += r.chars;
+    p.total.latency += r.latency;
+    p.total.decoded += r.decoded;
+    p.total.events += r.events;
+  }
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t1);
+  p.seconds = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+}
+
+static double cer(const Result &r)
+{
+  return r.chars ? 100.0 * r.errors / r.chars : 0;
+}
+
+static double latency(const Result &r)
+{
+  return r.decoded ? r.latency / r.decoded : 0;
+}
+
+// Where two runs lose characters
+static void print_conditions(const char *title, const Point &a, const Point &b)
+{
+  printf("\nCER %% by condition, %s\n", title);
+  printf("  wpm  jitter");
+  for (int w = 0; w < COUNT(weights); w++)
+    printf("   weight %+5.2f", weights[w]);
+  printf("\n");
+  for (size_t i = 0; i < conditions.size(); i += COUNT(weights)) {
+    printf("  %3d  %6.2f", conditions[i].wpm, conditions[i].jitter);
+    for (int w = 0; w < COUNT(weights); w++)
+      printf("   %5.1f / %5.1f", cer(a.results[i + w]), cer(b.results[i + w]));
+    printf("\n");
+  }
+}
+
+
+
+//==================
+// main
+//==================
+
+static void usage(void)
+{
+  fprintf(stderr, "usage: morsesweep [-j threads] [-n words] [-o file.csv] [-r cer] [-s Mcalls/s]\n");
+  exit(2);
+}
+
+int main(int argc, char **argv)
+{
+  int jobs = 0;
+  int words = 40;
+  const char *csv = 0;
+  double max_cer = -1, min_rate = -1;
+  int c;
+  while ((c = getopt(argc, argv, "j:n:o:r:s:")) != -1) {
+    switch (c) {
+      case 'j': jobs = atoi(optarg); break;
+      case 'n': words = atoi(optarg); break;
+      case 'o': csv = optarg; break;
+      case 'r': max_cer = atof(optarg); break;
+      case 's': min_rate = atof(optarg); break;
+      default: usage();
+    }
+  }
+  if (words < 1 || optind != argc)
+    usage();
+  if (jobs < 1)
+    jobs = std::thread::hardware_concurrency();
+  if (jobs < 1)
+    jobs = 1;
+
+  unsigned seed = 1;
+  for (int s = 0; s < COUNT(speeds); s++)
+    for (int j = 0; j < COUNT(jitters); j++)
+      for (int w = 0; w < COUNT(weights); w++) {
+        Condition cond;
+        cond.wpm = speeds[s];
+        cond.jitter = jitters[j];
+        cond.weight = weights[w];
+        make_condition(cond, words, seed++);
+        conditions.push_back(cond);
+      }
+
+  std::vector<Point> points;
+  int defaults = -1;
+  for (int a = 0; a < COUNT(markMins); a++)
+    for (int b = 0; b < COUNT(dashSplits); b++)
+      for (int g = 0; g < COUNT(charGaps); g++)
+        for (int w = 0; w < COUNT(wordGaps); w++) {
+          Point p = Point();
+          p.markMin = markMins[a];
+          p.dashSplit = dashSplits[b];
+          p.charGap = charGaps[g];
+          p.wordGap = wordGaps[w];
+          if (p.markMin == MORSE_MARK_MIN && p.dashSplit == MORSE_DASH_SPLIT &&
+              p.charGap == MORSE_CHAR_GAP && p.wordGap == MORSE_WORD_GAP)
+            defaults = points.size();
+          points.push_back(p);
+        }
+  // The defaults once more, in soft decision mode
+  size_t grid = points.size();
+  points.push_back(points[defaults]);
+  points[grid].soft = true;
+
+  // Thread pool over the grid
+  std::atomic<size_t> next(0);
+  std::vector<std::thread> threads;
+  struct timespec w0, w1;
+  clock_gettime(CLOCK_MONOTONIC, &w0);
+  for (int i = 0; i < jobs; i++) {
+    threads.push_back(std::thread([&] {
+      size_t n;
+      while ((n = next++) < points.size())
+        run_point(points[n]);
+    }));
+  }
+  for (size_t i = 0; i < threads.size(); i++)
+    threads[i].join();
+  clock_gettime(CLOCK_MONOTONIC, &w1);
+  double wall = (w1.tv_sec - w0.tv_sec) + (w1.tv_nsec - w0.tv_nsec) / 1e9;
+
+  long events = 0;
+  for (size_t i = 0; i < points.size(); i++)
+    events += points[i].total.events;
+  printf("%zu grid points x %zu conditions, %ld engine calls on %d threads in %.2f s\n\n",
+         grid, conditions.size(), events, jobs, wall);
+
+  // Best choices first, the defaults marked
+  std::vector<int> order(grid);
+  for (size_t i = 0; i < order.size(); i++)
+    order[i] = i;
+  std::sort(order.begin(), order.end(), [&](int a, int b) {
+    double ca = cer(points[a].total), cb = cer(points[b].total);
+    return ca != cb ? ca < cb : latency(points[a].total) < latency(points[b].total);
+  });
+  printf("markMin dashSplit charGap wordGap   CER %%  latency dots\n");
+  for (size_t i = 0; i < order.size(); i++) {
+    const Point &p = points[order[i]];
+    if (i >= 10 && order[i] != defaults)
+      continue;
+    printf("%7u %9u %7u %7u  %6.2f  %12.2f%s\n", p.markMin, p.dashSplit, p.charGap, p.wordGap,
+           cer(p.total), latency(p.total), order[i] == defaults ? "  <- default" : "");
+  }
+
+  const Point &def = points[defaults];
+  const Point &best = points[order[0]];
+  const Point &soft = points[grid];
+  print_conditions("default / best", def, best);
+  print_conditions("default / soft decision", def, soft);
+
+  double rate = def.total.events / def.seconds / 1e6;
+  printf("\ndefault thresholds: CER %.2f %%, latency %.2f dots, %.1f M engine calls/s\n",
+         cer(def.total), latency(def.total), rate);
+  printf("soft decision:      CER %.2f %%, latency %.2f dots, %.1f M engine calls/s\n",
+         cer(soft.total), latency(soft.total), soft.total.events / soft.seconds / 1e6);
+
+  if (csv) {
+    FILE *f = fopen(csv, "w");
+    if (!f) {
+      perror(csv);
+      return 2;
+    }
+    fprintf(f, "markMin,dashSplit,charGap,wordGap,soft,wpm,jitter,weight,chars,errors,cer,latency\n");
+    for (size_t i = 0; i < points.size(); i++)
+      for (size_t k = 0; k < conditions.size(); k++) {
+        const Point &p = points[i];
+        const Result &r = p.results[k];
+        fprintf(f, "%u,%u,%u,%u,%d,%d,%.2f,%.2f,%ld,%ld,%.3f,%.3f\n", p.markMin, p.dashSplit, p.charGap,
+                p.wordGap, p.soft, conditions[k].wpm, conditions[k].jitter, conditions[k].weight,
+                r.chars, r.errors, cer(r), latency(r));
+      }
+    fclose(f);
+  }
+
+  int fail = 0;
+  if (max_cer >= 0 && cer(def.total) > max_cer) {
+    fprintf(stderr, "FAIL: CER %.2f %% is above %.2f %%\n", cer(def.total), max_cer);
+    fail = 1;
+  }
+  if (min_rate >= 0 && rate < min_rate) {
+    fprintf(stderr, "FAIL: %.1f M engine calls/s is below %.1f\n", rate, min_rate);
+    fail = 1;
+  }
+  return fail;
+}